@@ -0,0 +1,184 @@
+#include "game.hpp"
+#include "gl_stub.hpp"
+#include "particles.hpp"
+#include "quality.hpp"
+#include "render.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Times the per-frame game code headless: particle update and spawning, car
+// movement, cactus traversal in drawSceneObjects, the ranking queries and
+// the CPU side of a whole frame at each quality preset. Rendering runs
+// against gl_stub.cpp, so the scene numbers are CPU cost plus the GL calls
+// the traversal would issue. `--quick` shortens every loop (the ctest smoke
+// run).
+
+namespace {
+    volatile long sink;
+
+    template <typename F>
+    double nsPer(long ops, F&& body) {
+        const auto t0 = std::chrono::steady_clock::now();
+        body();
+        const auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / ops;
+    }
+
+    float frand(float lo, float hi) {
+        return lo + (hi - lo) * (std::rand() / static_cast<float>(RAND_MAX));
+    }
+
+    void fillParticles(std::size_t count) {
+        particles.clear();
+        for (std::size_t i = 0; i < count; i++) {
+            particles.push_back({ frand(-3, 1), frand(0, 1), frand(0, 800),
+                                  frand(-0.5f, 0.5f), frand(0, 2), frand(-15, 0),
+                                  1e9f, frand(0.05f, 0.15f) });
+        }
+    }
+
+    void midRace() {
+        G = AppState();
+        G.gameStarted = true;
+        G.carPos = 200.0f;
+        G.carSpeed = 40.0f;
+        G.car2Pos = 190.0f;
+        G.car3Pos = 210.0f;
+    }
+
+    void benchParticles(int reps) {
+        // Immortal particles so every rep integrates the same count.
+        const std::size_t counts[] = { MAX_PARTICLES, 10000 };
+        for (std::size_t count : counts) {
+            fillParticles(count);
+            const double ns = nsPer(static_cast<long>(reps) * count, [&] {
+                for (int r = 0; r < reps; r++) updateParticles(1.0f / 60.0f);
+            });
+            std::printf("%-32s %8.2f ns/particle (%zu particles)\n", "updateParticles", ns, count);
+        }
+
+        fillParticles(MAX_PARTICLES);
+        const double ns = nsPer(reps, [&] {
+            for (int r = 0; r < reps; r++) spawnDustParticles(-1.0f, 100.0f, 40.0f, 0.0f);
+        });
+        std::printf("%-32s %8.2f ns/call (at the %zu cap)\n", "spawnDustParticles", ns, MAX_PARTICLES);
+    }
+
+    void benchCarMovement(int reps) {
+        midRace();
+        particles.clear();
+        const double ns = nsPer(reps, [&] {
+            for (int r = 0; r < reps; r++) {
+                G.carSpeed = 40.0f;
+                updateCarMovement(1.0f / 60.0f);
+                if (G.car3Pos > 700.0f) {
+                    G.carPos = 200.0f;
+                    G.car2Pos = 190.0f;
+                    G.car3Pos = 210.0f;
+                }
+            }
+        });
+        std::printf("%-32s %8.2f ns/tick (%zu particles live)\n", "updateCarMovement", ns, particles.size());
+    }
+
+    void benchScene(int reps) {
+        for (int views = 1; views <= 4; views *= 4) {
+            midRace();
+            G.chaseCam = true;
+            setViewCount(views);
+            frameArena.reset();
+            prepareFrame(1.0f / 60.0f, 1024, 768);
+
+            long cacti = 0;
+            for (int i = 0; i < frame.viewCount; i++) cacti += frame.views[i].cullEnd - frame.views[i].cullBegin;
+
+            glStubReset();
+            const double ns = nsPer(reps, [&] {
+                for (int r = 0; r < reps; r++)
+                    for (int i = 0; i < frame.viewCount; i++) drawSceneObjects(frame.views[i]);
+            });
+            const GlStubCounts c = glStubCounts;
+            std::printf("%-32s %8.2f ns/frame (%d view%s, %ld cacti in range)\n",
+                "drawSceneObjects", ns, views, views > 1 ? "s" : "", cacti);
+            std::printf("  per frame: %ld GL calls, %ld draws, %ld matrix ops, %ld vertices\n",
+                c.calls / reps, c.drawCalls / reps, c.matrixLoads / reps, c.vertices / reps);
+
+            glStubReset();
+            frameArena.reset();
+            prepareFrame(1.0f / 60.0f, 1024, 768);
+            renderFrame(1024, 768);
+            std::printf("  whole frame: %ld GL calls, %ld draws, %ld state changes\n",
+                glStubCounts.calls, glStubCounts.drawCalls, glStubCounts.stateChanges);
+        }
+    }
+
+    void benchPresets(int reps) {
+        for (const QualityPreset& q : qualityPresets) {
+            midRace();
+            G.chaseCam = true;
+            applyQuality(q);
+            setViewCount(1);
+            for (int i = 0; i < 120; i++) updateDust(1.0f / 60.0f);
+
+            const int w = static_cast<int>(q.windowWidth), h = static_cast<int>(q.windowHeight);
+            glStubReset();
+            terrainTriangles = 0;
+            terrainPatchStats = TerrainPatchStats();
+            const double ns = nsPer(reps, [&] {
+                for (int r = 0; r < reps; r++) {
+                    prepareFrame(1.0f / 60.0f, w, h);
+                    renderFrame(w, h);
+                    frameArena.reset();
+                }
+            });
+            char label[32];
+            std::snprintf(label, sizeof(label), "whole frame at %s", q.name);
+            std::printf("%-32s %8.3f ms/frame  %ld GL calls, %ld draws, %ld terrain tris in %d patches (%zu particles)\n",
+                label, ns / 1e6, glStubCounts.calls / reps, glStubCounts.drawCalls / reps,
+                terrainTriangles / reps, terrainPatchStats.highWater, particles.size());
+            if (terrainPatchStats.overflows) {
+                std::printf("  %ld views needed more than %d terrain patches\n", terrainPatchStats.overflows, TERRAIN_MAX_PATCHES);
+            }
+        }
+        applyQuality(qualityPresets[QUALITY_DEFAULT]);
+    }
+
+    void benchRanking(int reps) {
+        midRace();
+        long acc = 0;
+        const double ns = nsPer(reps, [&] {
+            for (int r = 0; r < reps; r++) {
+                G.car2Pos = static_cast<float>(r & 511);
+                acc += playerPlace() + raceFinished();
+            }
+        });
+        sink = acc;
+        std::printf("%-32s %8.2f ns/call\n", "playerPlace + raceFinished", ns);
+    }
+}
+
+int main(int argc, char** argv) {
+    const bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    const int reps = quick ? 50 : 20000;
+    std::srand(42);
+
+    initParticles();
+    initTerrain(nullptr);
+    initTerrainMesh();
+    initQuadric();
+    initSceneObjects();
+    initCarScene();
+
+    benchParticles(reps);
+    benchCarMovement(reps);
+    benchScene(quick ? 5 : 500);
+    benchRanking(reps * 10);
+    benchPresets(quick ? 2 : 100);
+
+    freeSceneObjects();
+    freeQuadric();
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+
+// Bump allocator for data that lives for one frame. reset() just rewinds the
+// offset; nothing allocated from it is ever destroyed individually, so only
+// trivially destructible types belong here.
+class FrameArena {
+public:
+    explicit FrameArena(std::size_t capacity)
+        : buffer(static_cast<unsigned char*>(std::malloc(capacity))), capacity(capacity) {}
+    ~FrameArena() { std::free(buffer); }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t align) {
+        const std::size_t start = (used + align - 1) & ~(align - 1);
+        if (start + bytes > capacity) {
+            overflows++;
+            return nullptr;
+        }
+        used = start + bytes;
+        highWater = std::max(highWater, used);
+        return buffer + start;
+    }
+
+    template <typename T>
+    T* alloc(std::size_t n) {
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void reset() { used = 0; }
+
+    std::size_t highWater = 0;
+    std::size_t overflows = 0;
+
+private:
+    unsigned char* buffer;
+    std::size_t capacity;
+    std::size_t used = 0;
+};
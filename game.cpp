@@ -0,0 +1,100 @@
+#include "game.hpp"
+#include "particles.hpp"
+
+#include <iostream>
+
+AppState G;
+
+float* const carPosOf[3] = { &G.carPos, &G.car2Pos, &G.car3Pos };
+float* const carSpeedOf[3] = { &G.carSpeed, &G.car2Speed, &G.car3Speed };
+int* const carPlaceOf[3] = { &G.carFinishPlace, &G.car2FinishPlace, &G.car3FinishPlace };
+const float carLanes[3] = { -1.0f, -3.0f, 1.0f };
+const char* const carNames[3] = { "Red Car", "Black Car", "Green Car" };
+
+Terrain terrain;
+
+void initTerrain(const char* heightmapPath) {
+    if (!heightmapPath || !terrain.loadRaw16(heightmapPath, 4.0f, 40.0f, 0.0f, 400.0f)) {
+        terrain.generateDunes(2049, 4.0f, 0.0f, 400.0f, 7);
+    }
+    terrain.flattenCorridor(-1.0f, 6.0f, 20.0f);
+    terrain.finalize();
+}
+
+void updateDust(float dt) {
+    updateParticles(dt);
+    
+    if (G.gameStarted) {
+        spawnDustParticles(-1.0f, G.carPos, G.carSpeed, groundHeight(-1.0f, G.carPos));
+        spawnDustParticles(-3.0f, G.car2Pos, G.car2Speed, groundHeight(-3.0f, G.car2Pos));
+        spawnDustParticles(1.0f, G.car3Pos, G.car3Speed, groundHeight(1.0f, G.car3Pos));
+    }
+}
+
+void updateCarMovement(float dt)
+{
+    
+    const float FINISH_LINE = 800.0f;
+    if (G.gameStarted) {
+        G.carPos += G.carSpeed * dt;
+    }
+    G.carSpeed *= 0.95f;
+
+    if (G.carPos >= FINISH_LINE && G.carFinishPlace == 0) {
+        G.finishOrder++;
+        G.carFinishPlace = G.finishOrder;
+        std::cout << "Red car finished in place: " << G.carFinishPlace << "\n";
+    }
+    
+    if (G.carPos > FINISH_LINE) {
+        G.carPos = FINISH_LINE;
+        G.carSpeed = 0.0f;
+    }
+    if (G.carPos < -45.0f) G.carPos = -45.0f;
+    
+
+    if (G.gameStarted) {
+     
+        if (!G.carRemote[1]) G.car2Pos += G.car2Speed * dt;
+    
+        if (G.car2Pos >= FINISH_LINE && G.car2FinishPlace == 0) {
+            G.finishOrder++;
+            G.car2FinishPlace = G.finishOrder;
+            std::cout << "Black car finished in place: " << G.car2FinishPlace << "\n";
+        }
+        
+        if (G.car2Pos > FINISH_LINE) {
+            G.car2Pos = FINISH_LINE;
+            G.car2Speed = 0.0f;
+        }
+        
+        if (!G.carRemote[2]) G.car3Pos += G.car3Speed * dt;
+        
+        if (G.car3Pos >= FINISH_LINE && G.car3FinishPlace == 0) {
+            G.finishOrder++;
+            G.car3FinishPlace = G.finishOrder;
+            std::cout << "Green car finished in place: " << G.car3FinishPlace << "\n";
+        }
+        
+        if (G.car3Pos > FINISH_LINE) {
+            G.car3Pos = FINISH_LINE;
+            G.car3Speed = 0.0f;
+        }
+    }
+
+    updateDust(dt);
+}
+
+bool raceFinished() {
+    return G.gameStarted && G.carPos >= 800.0f && G.car2Pos >= 800.0f && G.car3Pos >= 800.0f;
+}
+
+int playerPlace() {
+    const int me = G.localCar;
+    if (*carPlaceOf[me]) return *carPlaceOf[me];
+    int place = 1;
+    for (int i = 0; i < 3; i++) {
+        if (i != me && (*carPlaceOf[i] || *carPosOf[i] > *carPosOf[me])) place++;
+    }
+    return place;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "terrain.hpp"
+#include "vecmath.hpp"
+
+// Race state and simulation. Shared by the renderer and the app loop but
+// free of any GL or SFML dependency, so it can be driven headless.
+
+#define PI 3.14159265358979323846f
+
+struct AppState {
+    unsigned int skyTexture = 0;
+    unsigned int groundTexture = 0;
+    float carPos = 0.0f;
+    float carSpeed = 0.0f;
+    float wheelAngle = 0.0f;
+    float car2Pos = 0.0f;
+    float car2Speed = 35.0f;
+    float car3Pos = 0.0f;
+    float car3Speed = 45.0f;
+    float car2WheelAngle = 0.0f;
+    float car3WheelAngle = 0.0f;
+    float rotX = 0.f;
+    float rotY = -25.f;
+    bool brokenNoPushPop = false;
+    bool showLocalAxes = true;
+    vecmath::Vec3 eye{ 2.2f, 1.6f, 3.6f };
+    vecmath::Vec3 center{ 0.0f, 0.6f, 0.0f };
+    vecmath::Vec3 up{ 0.0f, 1.0f, 0.0f };
+    bool chaseCam = false;
+    float fovDeg = 60.0f;
+    float nearP = 0.1f, farP = 300.0f;
+    bool gameStarted = false;
+    
+    int finishOrder = 0;
+    int carFinishPlace = 0;
+    int car2FinishPlace = 0;
+    int car3FinishPlace = 0;
+    unsigned nitroUses = 0;
+    bool carRemote[3] = { false, false, false };
+    int localCar = 0;
+};
+
+extern AppState G;
+
+extern float* const carPosOf[3];
+extern float* const carSpeedOf[3];
+extern int* const carPlaceOf[3];
+extern const float carLanes[3];
+extern const char* const carNames[3];
+
+extern Terrain terrain;
+
+inline float groundHeight(float x, float z) { return terrain.heightAt(x, z); }
+
+inline float deg2rad(float d) { return d * PI / 180.f; }
+inline float clamp(float v, float a, float b) { return (v < a ? a : (v > b ? b : v)); }
+
+// Generates (or loads) the dune terrain and levels the race corridor.
+void initTerrain(const char* heightmapPath);
+
+// Ages the dust and, once the race is on, spawns more behind every car.
+void updateDust(float dt);
+void updateCarMovement(float dt);
+bool raceFinished();
+int playerPlace();
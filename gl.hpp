@@ -0,0 +1,15 @@
+#pragma once
+
+// The fixed pipeline plus the GL 2.x entry points (shaders, buffer objects)
+// the game calls directly.
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#include <OpenGL/glu.h>
+#else
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glu.h>
+#endif
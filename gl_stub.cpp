@@ -0,0 +1,86 @@
+#include "gl_stub.hpp"
+#include "gl.hpp"
+
+// No-op GL and GLU entry points covering everything render.cpp calls. Each
+// one only bumps the counters; queries report success so init code runs its
+// normal path.
+
+GlStubCounts glStubCounts;
+
+namespace {
+    GLuint nextName = 1;
+    int quadric;
+
+    void call() { glStubCounts.calls++; }
+    void draw() { glStubCounts.calls++; glStubCounts.drawCalls++; }
+    void matrix() { glStubCounts.calls++; glStubCounts.matrixLoads++; }
+    void state() { glStubCounts.calls++; glStubCounts.stateChanges++; }
+}
+
+void glEnable(GLenum) { state(); }
+void glDisable(GLenum) { state(); }
+void glEnableClientState(GLenum) { state(); }
+void glDisableClientState(GLenum) { state(); }
+void glBlendFunc(GLenum, GLenum) { state(); }
+void glDepthMask(GLboolean) { state(); }
+void glDepthFunc(GLenum) { state(); }
+void glClearDepth(GLclampd) { state(); }
+void glColorMaterial(GLenum, GLenum) { state(); }
+void glPolygonOffset(GLfloat, GLfloat) { state(); }
+void glLineWidth(GLfloat) { state(); }
+void glBindTexture(GLenum, GLuint) { state(); }
+void glTexParameteri(GLenum, GLenum, GLint) { state(); }
+void glLightfv(GLenum, GLenum, const GLfloat*) { state(); }
+void glMaterialf(GLenum, GLenum, GLfloat) { state(); }
+void glMaterialfv(GLenum, GLenum, const GLfloat*) { state(); }
+void glUseProgram(GLuint) { state(); }
+void glUniform1f(GLint, GLfloat) { state(); }
+void glUniform3f(GLint, GLfloat, GLfloat, GLfloat) { state(); }
+
+void glClear(GLbitfield) { call(); }
+void glViewport(GLint, GLint, GLsizei, GLsizei) { call(); }
+void glMatrixMode(GLenum) { call(); }
+void glLoadMatrixf(const GLfloat*) { matrix(); }
+void glPushMatrix() { matrix(); }
+void glPopMatrix() { call(); }
+void glTranslatef(GLfloat, GLfloat, GLfloat) { matrix(); }
+void glRotatef(GLfloat, GLfloat, GLfloat, GLfloat) { matrix(); }
+void glScalef(GLfloat, GLfloat, GLfloat) { matrix(); }
+
+void glBegin(GLenum) { draw(); }
+void glEnd() { call(); }
+void glVertex3f(GLfloat, GLfloat, GLfloat) { call(); glStubCounts.vertices++; }
+void glNormal3f(GLfloat, GLfloat, GLfloat) { call(); }
+void glTexCoord2f(GLfloat, GLfloat) { call(); }
+void glColor3f(GLfloat, GLfloat, GLfloat) { call(); }
+void glColor4f(GLfloat, GLfloat, GLfloat, GLfloat) { call(); }
+void glInterleavedArrays(GLenum, GLsizei, const GLvoid*) { call(); }
+void glDrawElements(GLenum, GLsizei count, GLenum, const GLvoid*) { draw(); glStubCounts.vertices += count; }
+
+GLuint glGenLists(GLsizei range) { call(); GLuint first = nextName; nextName += range; return first; }
+void glDeleteLists(GLuint, GLsizei) { call(); }
+void glNewList(GLuint, GLenum) { call(); }
+void glEndList() { call(); }
+void glCallList(GLuint) { draw(); }
+
+GLuint glCreateShader(GLenum) { call(); return nextName++; }
+void glShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) { call(); }
+void glCompileShader(GLuint) { call(); }
+void glDeleteShader(GLuint) { call(); }
+void glGetShaderiv(GLuint, GLenum, GLint* params) { call(); *params = GL_TRUE; }
+void glGetShaderInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* log) { call(); if (length) *length = 0; if (log) *log = '\0'; }
+GLuint glCreateProgram() { call(); return nextName++; }
+void glAttachShader(GLuint, GLuint) { call(); }
+void glLinkProgram(GLuint) { call(); }
+void glGetProgramiv(GLuint, GLenum, GLint* params) { call(); *params = GL_TRUE; }
+void glGetProgramInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* log) { call(); if (length) *length = 0; if (log) *log = '\0'; }
+GLint glGetUniformLocation(GLuint, const GLchar*) { call(); return 0; }
+GLint glGetAttribLocation(GLuint, const GLchar*) { call(); return 1; }
+void glVertexAttrib4f(GLuint, GLfloat, GLfloat, GLfloat, GLfloat) { call(); }
+
+GLUquadric* gluNewQuadric() { call(); return reinterpret_cast<GLUquadric*>(&quadric); }
+void gluDeleteQuadric(GLUquadric*) { call(); }
+void gluQuadricNormals(GLUquadric*, GLenum) { call(); }
+void gluCylinder(GLUquadric*, GLdouble, GLdouble, GLdouble, GLint, GLint) { draw(); }
+void gluDisk(GLUquadric*, GLdouble, GLdouble, GLint, GLint) { draw(); }
+void gluSphere(GLUquadric*, GLdouble, GLint, GLint) { draw(); }
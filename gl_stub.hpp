@@ -0,0 +1,15 @@
+#pragma once
+
+// Call counters kept by gl_stub.cpp, which stands in for libGL and libGLU
+// when render code is driven without a context (benchmarks, tests).
+struct GlStubCounts {
+    long calls = 0;
+    long drawCalls = 0;    // display lists, element arrays, GLU shapes and glBegin blocks
+    long vertices = 0;     // immediate-mode vertices and indexed elements
+    long matrixLoads = 0;  // glLoadMatrixf, glPushMatrix and the glTranslate/Rotate/Scale family
+    long stateChanges = 0; // enables, blend/depth state, textures, programs and uniforms
+};
+
+extern GlStubCounts glStubCounts;
+
+inline void glStubReset() { glStubCounts = GlStubCounts(); }
@@ -1,8 +1,7 @@
+#include "gl.hpp"
 #include <SFML/Window.hpp>
 #include <SFML/Graphics.hpp>
 #include <SFML/OpenGL.hpp>
-#include <OpenGL/gl.h>
-#include <OpenGL/glu.h>
 #include <iostream>
 #include <cmath>
 #include <optional>
@@ -10,169 +9,109 @@
 #include <algorithm>
 #include <fstream>
 #include <sstream>
+#include "telemetry.hpp"
+#include "net.hpp"
+#include "vecmath.hpp"
+#include "terrain.hpp"
+#include "particle_sort.hpp"
+#include "frame_arena.hpp"
+#include "game.hpp"
+#include "particles.hpp"
+#include "render.hpp"
+#include "quality.hpp"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+
+enum class AllocTag { Other, Input, Simulation, Render, Hud, Present, Count };
+
+static const char* const allocTagNames[] = { "other", "input", "simulation", "render", "hud", "present" };
+
+struct AllocCounter {
+    std::atomic<std::uint64_t> count{ 0 };
+    std::atomic<std::uint64_t> bytes{ 0 };
+};
 
-#define PI 3.14159265358979323846f
-
-GLuint shaderProgram = 0;
-
-std::string loadShaderSource(const std::string& filename) {
-    std::ifstream file(filename);
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
-
-GLuint compileShader(GLenum type, const std::string& source) {
-    GLuint shader = glCreateShader(type);
-    const char* src = source.c_str();
-    glShaderSource(shader, 1, &src, NULL);
-    glCompileShader(shader);
-    
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cout << "Shader error: " << infoLog << std::endl;
-    }
-    return shader;
+// Counters live in zero-initialised static storage so they are valid before
+// any dynamic initialisation runs operator new.
+static AllocCounter allocCounters[static_cast<int>(AllocTag::Count)];
+static thread_local AllocTag allocTag = AllocTag::Other;
+
+void* operator new(std::size_t size) {
+    AllocCounter& c = allocCounters[static_cast<int>(allocTag)];
+    c.count.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
 }
 
-void initShaders() {
-    std::string vertexCode = loadShaderSource("phong.vert");
-    std::string fragmentCode = loadShaderSource("phong.frag");
-    
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode);
-    
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    
-    GLint success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "Linking error: " << infoLog << std::endl;
-    }
-    
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    
-    std::cout << "✓ Phong shaders loaded!\n";
-}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
 
-bool colorMaterialEnabled = true;
-struct Particle {
-    float x, y, z;
-    float vx, vy, vz;
-    float life;
-    float size;
+struct AllocReport {
+    std::uint64_t lastCount[static_cast<int>(AllocTag::Count)] = {};
+    std::uint64_t lastBytes[static_cast<int>(AllocTag::Count)] = {};
+    std::uint64_t frames = 0;
+    std::uint64_t framesWithAllocs = 0;
+    std::uint64_t peakFrameCount = 0;
+    bool trace = false;
 };
 
-static std::vector<Particle> particles;
+static AllocReport allocReport;
+
+static void allocFrameEnd() {
+    std::uint64_t frameCount = 0;
+    std::uint64_t count[static_cast<int>(AllocTag::Count)];
+    std::uint64_t bytes[static_cast<int>(AllocTag::Count)];
+    for (int i = 0; i < static_cast<int>(AllocTag::Count); i++) {
+        const std::uint64_t c = allocCounters[i].count.load(std::memory_order_relaxed);
+        const std::uint64_t b = allocCounters[i].bytes.load(std::memory_order_relaxed);
+        count[i] = c - allocReport.lastCount[i];
+        bytes[i] = b - allocReport.lastBytes[i];
+        allocReport.lastCount[i] = c;
+        allocReport.lastBytes[i] = b;
+        frameCount += count[i];
+    }
 
-static void initParticles() {
-    particles.reserve(200);
-}
+    allocReport.frames++;
+    if (frameCount == 0) return;
+    allocReport.framesWithAllocs++;
+    allocReport.peakFrameCount = std::max(allocReport.peakFrameCount, frameCount);
 
-static void updateParticles(float dt) {
-    particles.erase(
-        std::remove_if(particles.begin(), particles.end(),
-            [](const Particle& p) { return p.life <= 0.0f; }),
-        particles.end()
-    );
-    
-    for (auto& p : particles) {
-        p.x += p.vx * dt;
-        p.y += p.vy * dt;
-        p.z += p.vz * dt;
-        p.life -= dt;
-        p.vy -= 0.5f * dt;
+    if (allocReport.trace) {
+        std::printf("frame %llu: %llu allocs", (unsigned long long)allocReport.frames, (unsigned long long)frameCount);
+        for (int i = 0; i < static_cast<int>(AllocTag::Count); i++) {
+            if (count[i]) std::printf("  %s %llu/%lluB", allocTagNames[i], (unsigned long long)count[i], (unsigned long long)bytes[i]);
+        }
+        std::printf("\n");
     }
 }
 
-static void drawParticles(GLUquadric* gQuad) {
-    glDisable(GL_LIGHTING);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDepthMask(GL_FALSE);
-
-    for (const auto& p : particles) {
-        float alpha = p.life / 1.0f;
-        glColor4f(0.8f, 0.7f, 0.5f, alpha * 0.6f);
-        
-        glPushMatrix();
-        glTranslatef(p.x, p.y, p.z);
-        gluSphere(gQuad, p.size, 6, 6);
-        glPopMatrix();
+static void printAllocReport() {
+    std::printf("Heap: %llu of %llu frames allocated (peak %llu allocs in one frame)\n",
+        (unsigned long long)allocReport.framesWithAllocs, (unsigned long long)allocReport.frames,
+        (unsigned long long)allocReport.peakFrameCount);
+    for (int i = 0; i < static_cast<int>(AllocTag::Count); i++) {
+        std::printf("  %-10s %8llu allocs %10llu bytes\n", allocTagNames[i],
+            (unsigned long long)allocCounters[i].count.load(), (unsigned long long)allocCounters[i].bytes.load());
     }
-    
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
-    glEnable(GL_LIGHTING);
-}
-
-static void spawnDustParticles(float carX, float carZ, float speed) {
-    if (std::abs(speed) < 0.1f) return;
-    for (int i = 0; i < 5; i++) {
-        Particle p;
-        p.x = carX + ((rand() % 100) / 100.0f - 0.5f) * 0.5f;
-        p.y = 0.1f;
-        p.z = carZ - 0.5f + ((rand() % 100) / 100.0f - 0.5f) * 0.3f;
-        
-        p.vx = ((rand() % 100) / 100.0f - 0.5f) * 1.0f;
-        p.vy = (rand() % 100) / 100.0f * 2.0f;
-        p.vz = -std::abs(speed) * 0.3f + ((rand() % 100) / 100.0f - 0.5f) * 0.5f;
-        
-        p.life = 0.5f + (rand() % 100) / 100.0f * 0.5f;
-        p.size = 0.05f + (rand() % 100) / 100.0f * 0.1f;
-        
-        particles.push_back(p);
-    }
-
-    if (particles.size() > 200) {
-        particles.erase(particles.begin(), particles.begin() + (particles.size() - 200));
-    }
-}
-
-
-
-namespace {
-    struct AppState {
-        GLuint skyTexture = 0;
-        GLuint groundTexture = 0;
-        float carPos = 0.0f;
-        float carSpeed = 0.0f;
-        float wheelAngle = 0.0f;
-        float car2Pos = 0.0f;
-        float car2Speed = 35.0f;
-        float car3Pos = 0.0f;
-        float car3Speed = 45.0f;
-        float rotX = 0.f;
-        float rotY = -25.f;
-        bool brokenNoPushPop = false;
-        bool showLocalAxes = true;
-        sf::Vector3f eye{ 2.2f, 1.6f, 3.6f };
-        sf::Vector3f center{ 0.0f, 0.6f, 0.0f };
-        sf::Vector3f up{ 0.0f, 1.0f, 0.0f };
-        bool chaseCam = false;
-        float fovDeg = 60.0f;
-        float nearP = 0.1f, farP = 300.0f;
-        bool gameStarted = false;
-        
-        int finishOrder = 0;
-        int carFinishPlace = 0;
-        int car2FinishPlace = 0;
-        int car3FinishPlace = 0;
-    } G;
+}
 
-    float deg2rad(float d) { return d * PI / 180.f; }
-    float clamp(float v, float a, float b) { return (v < a ? a : (v > b ? b : v)); }
+static void printArenaReport(const FrameArena& arena) {
+    std::printf("Frame arena: high water %zu bytes, %zu overflows\n", arena.highWater, arena.overflows);
+    std::printf("Terrain patches: high water %d of %d per view, %ld overflows\n",
+        terrainPatchStats.highWater, TERRAIN_MAX_PATCHES, terrainPatchStats.overflows);
 }
 
+bool colorMaterialEnabled = true;
+
 bool loadTexture(const std::string& filename, GLuint& texID) {
     sf::Image img;
     if (!img.loadFromFile(filename)) return false;
@@ -180,6 +119,7 @@ bool loadTexture(const std::string& filename, GLuint& texID) {
     glBindTexture(GL_TEXTURE_2D, texID);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
         img.getSize().x, img.getSize().y, 0,
         GL_RGBA, GL_UNSIGNED_BYTE, img.getPixelsPtr());
@@ -187,617 +127,766 @@ bool loadTexture(const std::string& filename, GLuint& texID) {
     return true;
 }
 
-static void drawSky(float size = 50.0f)
-{
-    glDisable(GL_LIGHTING);
-    glDisable(GL_DEPTH_TEST);
-    
-    if (G.skyTexture) {
-        glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, G.skyTexture);
-        glColor3f(1.0f, 1.0f, 1.0f);
-    } else {
-        glColor3f(0.4f, 0.6f, 0.9f);
-    }
-
-    glBegin(GL_QUADS);
-
-    glTexCoord2f(0, 0); glVertex3f(-size, -size, -size);
-    glTexCoord2f(1, 0); glVertex3f(size, -size, -size);
-    glTexCoord2f(1, 1); glVertex3f(size, size, -size);
-    glTexCoord2f(0, 1); glVertex3f(-size, size, -size);
-   
-    glTexCoord2f(0, 0); glVertex3f(-size, -size, size);
-    glTexCoord2f(1, 0); glVertex3f(size, -size, size);
-    glTexCoord2f(1, 1); glVertex3f(size, size, size);
-    glTexCoord2f(0, 1); glVertex3f(-size, size, size);
-   
-    glTexCoord2f(0, 0); glVertex3f(-size, -size, -size);
-    glTexCoord2f(1, 0); glVertex3f(-size, -size, size);
-    glTexCoord2f(1, 1); glVertex3f(-size, size, size);
-    glTexCoord2f(0, 1); glVertex3f(-size, size, -size);
-    
-    glTexCoord2f(0, 0); glVertex3f(size, -size, -size);
-    glTexCoord2f(1, 0); glVertex3f(size, -size, size);
-    glTexCoord2f(1, 1); glVertex3f(size, size, size);
-    glTexCoord2f(0, 1); glVertex3f(size, size, -size);
-    
-    glTexCoord2f(0, 0); glVertex3f(-size, size, -size);
-    glTexCoord2f(1, 0); glVertex3f(size, size, -size);
-    glTexCoord2f(1, 1); glVertex3f(size, size, size);
-    glTexCoord2f(0, 1); glVertex3f(-size, size, size);
-    glEnd();
-
-    if (G.skyTexture) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDisable(GL_TEXTURE_2D);
+struct Hud {
+    sf::Text startText;
+    sf::Text controlsText;
+    sf::Text statusText;
+    sf::Text winText;
+    sf::Text rankingText;
+
+    int shownPlace = -1;
+    int shownSpeed = -1;
+    int shownDist = -1;
+    std::int64_t statusDueUs = 0;
+    bool resultsBuilt = false;
+    char status[96] = "";
+    sf::String statusString;
+
+    explicit Hud(const sf::Font& font)
+        : startText(font, "Press SPACE to start the race!", 30),
+          controlsText(font, "W - Forward  |  S - Backward  |  Q - Nitro", 20),
+          statusText(font, "", 22),
+          winText(font, "", 60),
+          rankingText(font, "", 30) {
+        startText.setFillColor(sf::Color::White);
+        startText.setPosition({300.f, 50.f});
+        controlsText.setFillColor(sf::Color::White);
+        controlsText.setPosition({10.f, 720.f});
+        statusText.setFillColor(sf::Color::Yellow);
+        statusText.setPosition({10.f, 10.f});
+        winText.setPosition({250.f, 250.f});
+        rankingText.setFillColor(sf::Color::White);
+        rankingText.setPosition({300.f, 350.f});
+
+        // Sizes the status string and the text's vertex buffers for the
+        // fixed-width line, and loads every digit glyph before the race.
+        statusString = "Position: 0/3   Speed: 245   Lap 1/1: 679/800";
+        statusText.setString(statusString);
+        (void)statusText.getLocalBounds();
     }
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING);
-}
-
+};
 
-static void initOpenGL() {
-    glColor3f(0.8f, 0.0f, 0.0f);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_COLOR_MATERIAL);
-    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
-    glDisable(GL_BLEND);
+// Text geometry is rebuilt only when a displayed value changes. Speed and
+// distance change nearly every frame while racing, so the status line is
+// refreshed at most 10 times a second (a place change shows at once). The
+// numbers are padded to a fixed width and written over the characters of
+// hud.statusString, so neither the string nor the text's copy of it (same
+// length) reallocates.
+static void updateHud(Hud& hud, std::int64_t nowUs) {
+    if (!G.gameStarted) return;
+
+    const int place = playerPlace();
+    const int speed = static_cast<int>(std::abs(*carSpeedOf[G.localCar]));
+    const int dist = static_cast<int>(clamp(*carPosOf[G.localCar], 0.0f, 800.0f));
+    const bool due = nowUs >= hud.statusDueUs || place != hud.shownPlace;
+    if (due && (place != hud.shownPlace || speed != hud.shownSpeed || dist != hud.shownDist)) {
+        hud.statusDueUs = nowUs + 100000;
+        hud.shownPlace = place;
+        hud.shownSpeed = speed;
+        hud.shownDist = dist;
+        const int len = std::snprintf(hud.status, sizeof(hud.status),
+            "Position: %d/3   Speed: %-3d   Lap 1/1: %3d/800", place, speed, dist);
+        if (len != static_cast<int>(hud.statusString.getSize())) hud.statusString = hud.status;
+        else for (int i = 0; i < len; i++) hud.statusString[i] = static_cast<unsigned char>(hud.status[i]);
+        hud.statusText.setString(hud.statusString);
+    }
 
-    GLfloat lightPos[] = { 1.0, 1.0, 1.0, 0.0 };
-    GLfloat white[] = { 1.0, 1.0, 1.0, 1.0 };
+    // On a client raceFinished() can turn true from the locally predicted
+    // position before the server's snapshot carries every finish place, so
+    // the results wait until all three are known.
+    const bool placesKnown = *carPlaceOf[0] != 0 && *carPlaceOf[1] != 0 && *carPlaceOf[2] != 0;
+    if (raceFinished() && placesKnown && !hud.resultsBuilt) {
+        hud.resultsBuilt = true;
+        if (*carPlaceOf[G.localCar] == 1) {
+            hud.winText.setString("YOU WIN!");
+            hud.winText.setFillColor(sf::Color::Red);
+        }
+        else {
+            hud.winText.setString("YOU LOSE!");
+            hud.winText.setFillColor(sf::Color::White);
+        }
 
-    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, white);
-    glLightfv(GL_LIGHT0, GL_SPECULAR, white);
+        const char* names[4] = { "", "", "", "" };
+        const char* you[4] = { "", "", "", "" };
+        for (int i = 0; i < 3; i++) {
+            names[*carPlaceOf[i]] = carNames[i];
+            if (i == G.localCar) you[*carPlaceOf[i]] = " (YOU)";
+        }
 
-    glDepthFunc(GL_LEQUAL);
-    glClearDepth(1.0f);
+        char ranking[128];
+        std::snprintf(ranking, sizeof(ranking),
+            "FINAL RESULTS:\n\n1st: %s%s\n2nd: %s%s\n3rd: %s%s",
+            names[1], you[1], names[2], you[2], names[3], you[3]);
+        hud.rankingText.setString(ranking);
+    }
 }
 
-void initLighting() {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-
-    GLfloat lightAmbient[] = { 0.1f, 0.1f, 0.1f, 1.0f };
-    GLfloat lightDiffuse[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmbient);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiffuse);
+// One pushGLStates/popGLStates pair covers every overlay element.
+static void drawHud(sf::RenderWindow& win, const Hud& hud) {
+    win.pushGLStates();
+    if (!G.gameStarted) {
+        win.draw(hud.startText);
+    }
+    else if (!hud.resultsBuilt) {
+        win.draw(hud.statusText);
+        win.draw(hud.controlsText);
+    }
+    else {
+        win.draw(hud.statusText);
+        win.draw(hud.winText);
+        win.draw(hud.rankingText);
+    }
+    win.popGLStates();
 }
 
-void setMaterial(float shininess) {
-    GLfloat mat_ambient[] = { 0.2f, 0.2f, 0.2f, 1.0f };
-    GLfloat mat_specular[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+static sf::Clock appClock;
 
-    glMaterialfv(GL_FRONT, GL_AMBIENT, mat_ambient);
-    glMaterialf(GL_FRONT, GL_SHININESS, shininess);
+static std::int64_t nowUs() {
+    return appClock.getElapsedTime().asMicroseconds();
 }
 
+// Input-to-photon tracking: a key press is handed to the simulation by the
+// next update and retired by the display() call that first presents the
+// resulting frame. SFML gives no event timestamps, so a press is stamped with
+// the end of the previous poll, the earliest moment it could have been
+// queued: the report is an upper bound. Stamping at poll time would drop the
+// time spent queued during the low-latency sleep.
+struct LatencyTracker {
+    static constexpr int BUCKETS = 64;
+    static constexpr std::int64_t BUCKET_US = 1000;
+
+    std::int64_t pendingUs = -1;
+    std::int64_t simulatedUs = -1;
+    std::uint32_t histogram[BUCKETS] = {};
+    std::uint32_t samples = 0;
+    std::int64_t totalUs = 0;
+    std::int64_t maxUs = 0;
+};
 
-static void setupProjection(sf::Vector2u s) {
-    if (!s.y) s.y = 1;
-    const double aspect = s.x / static_cast<double>(s.y);
+static LatencyTracker latency;
 
-    glViewport(0, 0, (GLsizei)s.x, (GLsizei)s.y);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(G.fovDeg, aspect, G.nearP, G.farP);
-    glMatrixMode(GL_MODELVIEW);
+static void latencyInput(std::int64_t t) {
+    if (latency.pendingUs < 0) latency.pendingUs = t;
 }
 
+static void latencySimulated() {
+    if (latency.pendingUs < 0 || latency.simulatedUs >= 0) return;
+    latency.simulatedUs = latency.pendingUs;
+    latency.pendingUs = -1;
+}
 
-static void setupView() {
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+static void latencyPresented(std::int64_t t) {
+    if (latency.simulatedUs < 0) return;
+    const std::int64_t us = t - latency.simulatedUs;
+    latency.simulatedUs = -1;
+
+    int bucket = static_cast<int>(us / LatencyTracker::BUCKET_US);
+    if (bucket >= LatencyTracker::BUCKETS) bucket = LatencyTracker::BUCKETS - 1;
+    latency.histogram[bucket]++;
+    latency.samples++;
+    latency.totalUs += us;
+    if (us > latency.maxUs) latency.maxUs = us;
+}
 
-    if (G.chaseCam) {
-        float camDistance = 3.0f;
-        float camHeight = 1.5f;
-        sf::Vector3f camPos(-1.0f, camHeight, G.carPos - camDistance);
-        sf::Vector3f camTarget(-1.0f, 0.6f, G.carPos);
-        
-        gluLookAt(camPos.x, camPos.y, camPos.z,
-                  camTarget.x, camTarget.y, camTarget.z,
-                  0, 1, 0);
-    }
-    else {
-        gluLookAt(G.eye.x, G.eye.y, G.eye.z,
-                  G.center.x, G.center.y, G.center.z,
-                  G.up.x, G.up.y, G.up.z);
+static int latencyPercentileMs(float pct) {
+    const std::uint32_t target = static_cast<std::uint32_t>(latency.samples * pct);
+    std::uint32_t seen = 0;
+    for (int i = 0; i < LatencyTracker::BUCKETS; i++) {
+        seen += latency.histogram[i];
+        if (seen > target) return i + 1;
     }
+    return LatencyTracker::BUCKETS;
 }
 
-static void drawAxes(float len = 0.4f) {
-    glDisable(GL_LIGHTING);
-    glLineWidth(2.0f);
-    glBegin(GL_LINES);
-    glColor3f(1, 0, 0); glVertex3f(0, 0, 0); glVertex3f(+len, 0, 0);
-    glColor3f(0, 1, 0); glVertex3f(0, 0, 0); glVertex3f(0, +len, 0);
-    glColor3f(0, 0, 1); glVertex3f(0, 0, 0); glVertex3f(0, 0, +len);
-    glEnd();
-    glEnable(GL_LIGHTING);
+static void printLatencyReport() {
+    if (latency.samples == 0) return;
+    std::cout << "Input latency, upper bound (" << latency.samples << " samples): avg "
+              << latency.totalUs / latency.samples / 1000.0 << " ms, p50 <"
+              << latencyPercentileMs(0.50f) << " ms, p95 <"
+              << latencyPercentileMs(0.95f) << " ms, max "
+              << latency.maxUs / 1000.0 << " ms\n";
+
+    std::uint32_t peak = 1;
+    for (std::uint32_t n : latency.histogram) peak = std::max(peak, n);
+    for (int i = 0; i < LatencyTracker::BUCKETS; i++) {
+        if (!latency.histogram[i]) continue;
+        char bar[41];
+        const int len = static_cast<int>(40ull * latency.histogram[i] / peak);
+        std::memset(bar, '#', len);
+        bar[len] = '\0';
+        std::printf("%3d-%3d ms %6u %s\n", i, i + 1, latency.histogram[i], bar);
+    }
 }
 
+// Low-latency pacing keeps vsync on but, instead of polling input right after
+// the previous swap, sleeps until just before the next vblank minus the
+// expected frame cost, so the presented frame reflects fresher input.
+struct FramePacer {
+    bool lowLatency = false;
+    float periodUs = 16667.0f;
+    float workUs = 4000.0f;
+    std::int64_t lastPresentUs = 0;
+};
 
-static GLUquadric* gQuad = nullptr;
+static FramePacer pacer;
 
-static void initQuadric() {
-    gQuad = gluNewQuadric();
-    gluQuadricNormals(gQuad, GLU_SMOOTH);
+static void waitForInputDeadline() {
+    if (!pacer.lowLatency || pacer.lastPresentUs == 0) return;
+    const float marginUs = 1500.0f;
+    const std::int64_t deadline = pacer.lastPresentUs +
+        static_cast<std::int64_t>(pacer.periodUs - pacer.workUs - marginUs);
+    const std::int64_t wait = deadline - nowUs();
+    if (wait > 0) sf::sleep(sf::microseconds(wait));
 }
 
-static void freeQuadric() {
-    if (gQuad) gluDeleteQuadric(gQuad);
+static void pacerFrameDone(std::int64_t frameStartUs, std::int64_t submitUs, std::int64_t presentUs) {
+    const float work = static_cast<float>(submitUs - frameStartUs);
+    pacer.workUs = std::max(work, pacer.workUs * 0.98f + work * 0.02f);
+
+    if (pacer.lastPresentUs != 0) {
+        const float interval = static_cast<float>(presentUs - pacer.lastPresentUs);
+        if (interval > 2000.0f && interval < pacer.periodUs * 1.5f) {
+            pacer.periodUs = pacer.periodUs * 0.95f + interval * 0.05f;
+        }
+    }
+    pacer.lastPresentUs = presentUs;
 }
 
-static void drawWheel(float radius = 0.25f, float width = 0.15f) {
-    glPushMatrix();
+enum class CaptureFormat { Png, Yuv };
+
+// Race recording. Each frame is read back into one of a ring of pixel pack
+// buffers, and the buffer filled PBO_COUNT frames earlier (long since
+// finished by the GPU) is mapped and copied into a free slot for the
+// encoder threads. When every slot is busy the frame is dropped rather than
+// stalling the render loop.
+struct FrameCapture {
+    static constexpr int PBO_COUNT = 3;
+    static constexpr int SLOT_COUNT = 8;
+
+    bool active = false;
+    CaptureFormat format = CaptureFormat::Png;
+    unsigned width = 0, height = 0;
+    GLuint pbos[PBO_COUNT] = {};
+    std::uint64_t issued = 0;
+    std::uint64_t queued = 0;
+    std::uint64_t dropped = 0;
+
+    std::vector<std::uint8_t> slotPixels[SLOT_COUNT];
+    std::uint64_t slotFrame[SLOT_COUNT] = {};
+    int ready[SLOT_COUNT] = {};
+    int readyHead = 0, readyCount = 0;
+    int freeSlots[SLOT_COUNT] = {};
+    int freeCount = 0;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::thread> workers;
+    std::FILE* yuv = nullptr;
+    char path[64] = "";            // this take's PNG directory or .yuv file
+
+    std::int64_t readbackUs = 0;
+    std::int64_t capturedFrameUs = 0, capturedFrames = 0;
+    std::int64_t plainFrameUs = 0, plainFrames = 0;
+};
 
-    glColor3f(0.1f, 0.1f, 0.1f);
-    glRotatef(90, 0, 1, 0);
+static FrameCapture capture;
 
-    gluCylinder(gQuad, radius, radius, width, 24, 1);
-    gluDisk(gQuad, 0.0, radius, 24, 1);
+static void encodePng(const std::uint8_t* rgba, std::uint64_t index, std::vector<std::uint8_t>& scratch) {
+    const unsigned w = capture.width, h = capture.height;
+    const size_t row = static_cast<size_t>(w) * 4;
+    scratch.resize(row * h);
+    for (unsigned y = 0; y < h; y++) {
+        std::memcpy(&scratch[y * row], rgba + (h - 1 - y) * row, row);
+    }
 
-    glTranslatef(0, 0, width);
-    gluDisk(gQuad, 0.0, radius, 24, 1);
+    char path[64];
+    std::snprintf(path, sizeof(path), "%s/frame_%06llu.png", capture.path, (unsigned long long)index);
+    sf::Image img({ w, h }, scratch.data());
+    if (!img.saveToFile(path)) {
+        std::cout << "Nie można zapisać klatki " << path << "\n";
+    }
+}
 
-    glPopMatrix();
+static void encodeYuv(const std::uint8_t* rgba, std::vector<std::uint8_t>& scratch) {
+    const unsigned w = capture.width & ~1u, h = capture.height & ~1u;
+    const size_t stride = static_cast<size_t>(capture.width) * 4;
+    scratch.resize(static_cast<size_t>(w) * h * 3 / 2);
+    std::uint8_t* yPlane = scratch.data();
+    std::uint8_t* uPlane = yPlane + w * h;
+    std::uint8_t* vPlane = uPlane + (w / 2) * (h / 2);
+
+    for (unsigned y = 0; y < h; y++) {
+        const std::uint8_t* src = rgba + (capture.height - 1 - y) * stride;
+        for (unsigned x = 0; x < w; x++) {
+            const int r = src[x * 4], g = src[x * 4 + 1], b = src[x * 4 + 2];
+            yPlane[y * w + x] = static_cast<std::uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+    for (unsigned y = 0; y < h; y += 2) {
+        const std::uint8_t* row0 = rgba + (capture.height - 1 - y) * stride;
+        const std::uint8_t* row1 = row0 - stride;
+        for (unsigned x = 0; x < w; x += 2) {
+            const int r = (row0[x * 4] + row0[x * 4 + 4] + row1[x * 4] + row1[x * 4 + 4]) / 4;
+            const int g = (row0[x * 4 + 1] + row0[x * 4 + 5] + row1[x * 4 + 1] + row1[x * 4 + 5]) / 4;
+            const int b = (row0[x * 4 + 2] + row0[x * 4 + 6] + row1[x * 4 + 2] + row1[x * 4 + 6]) / 4;
+            const size_t i = (y / 2) * (w / 2) + x / 2;
+            uPlane[i] = static_cast<std::uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[i] = static_cast<std::uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+    std::fwrite(scratch.data(), 1, scratch.size(), capture.yuv);
 }
 
-static void drawBox(float sx, float sy, float sz) {
-    glPushMatrix();
-    glScalef(sx, sy, sz);
+static void captureWorker() {
+    std::vector<std::uint8_t> scratch;
+    for (;;) {
+        int slot;
+        {
+            std::unique_lock<std::mutex> lock(capture.mutex);
+            capture.cv.wait(lock, [] { return capture.readyCount > 0 || capture.stopping; });
+            if (capture.readyCount == 0) return;
+            slot = capture.ready[capture.readyHead];
+            capture.readyHead = (capture.readyHead + 1) % FrameCapture::SLOT_COUNT;
+            capture.readyCount--;
+        }
 
-    glBegin(GL_QUADS);
-    glNormal3f(0.0f, 0.0f, 1.0f); glVertex3f(-0.5, -0.5, 0.5); glVertex3f(0.5, -0.5, 0.5); glVertex3f(0.5, 0.5, 0.5); glVertex3f(-0.5, 0.5, 0.5);
-    glNormal3f(0.0f, 0.0f, -1.0f); glVertex3f(-0.5, -0.5, -0.5); glVertex3f(-0.5, 0.5, -0.5); glVertex3f(0.5, 0.5, -0.5); glVertex3f(0.5, -0.5, -0.5);
-    glNormal3f(-1.0f, 0.0f, 0.0f); glVertex3f(-0.5, -0.5, -0.5); glVertex3f(-0.5, -0.5, 0.5); glVertex3f(-0.5, 0.5, 0.5); glVertex3f(-0.5, 0.5, -0.5);
-    glNormal3f(1.0f, 0.0f, 0.0f); glVertex3f(0.5, -0.5, -0.5); glVertex3f(0.5, 0.5, -0.5); glVertex3f(0.5, 0.5, 0.5); glVertex3f(0.5, -0.5, 0.5);
-    glNormal3f(0.0f, 1.0f, 0.0f); glVertex3f(-0.5, 0.5, 0.5); glVertex3f(0.5, 0.5, 0.5); glVertex3f(0.5, 0.5, -0.5); glVertex3f(-0.5, 0.5, -0.5);
-    glNormal3f(0.0f, -1.0f, 0.0f); glVertex3f(-0.5, -0.5, 0.5); glVertex3f(-0.5, -0.5, -0.5); glVertex3f(0.5, -0.5, -0.5); glVertex3f(0.5, -0.5, 0.5);
-    glEnd();
+        if (capture.format == CaptureFormat::Png) {
+            encodePng(capture.slotPixels[slot].data(), capture.slotFrame[slot], scratch);
+        }
+        else {
+            encodeYuv(capture.slotPixels[slot].data(), scratch);
+        }
 
-    glPopMatrix();
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        capture.freeSlots[capture.freeCount++] = slot;
+    }
 }
 
-static void updateCarMovement(float dt)
-{
-    
-    const float FINISH_LINE = 800.0f;
-    if (G.gameStarted) {
-        G.carPos += G.carSpeed * dt;
+// Every recording gets the first unused take number, shared by both formats,
+// so a restart never overwrites an earlier take.
+static void nextCapturePath(CaptureFormat format) {
+    for (int take = 1;; take++) {
+        char dir[32], yuv[32];
+        std::snprintf(dir, sizeof(dir), "capture/take_%03d", take);
+        std::snprintf(yuv, sizeof(yuv), "capture_%03d.yuv", take);
+        std::error_code ec;
+        if (std::filesystem::exists(dir, ec) || std::filesystem::exists(yuv, ec)) continue;
+        std::snprintf(capture.path, sizeof(capture.path), "%s", format == CaptureFormat::Png ? dir : yuv);
+        return;
     }
-    G.carSpeed *= 0.95f;
+}
 
-    if (G.carPos >= FINISH_LINE && G.carFinishPlace == 0) {
-        G.finishOrder++;
-        G.carFinishPlace = G.finishOrder;
-        std::cout << "Red car finished in place: " << G.carFinishPlace << "\n";
+static void startCapture(sf::Vector2u size, CaptureFormat format) {
+    capture.format = format;
+    capture.width = size.x;
+    capture.height = size.y;
+    capture.issued = capture.queued = capture.dropped = 0;
+    capture.readbackUs = 0;
+    capture.capturedFrameUs = capture.capturedFrames = 0;
+    capture.readyHead = capture.readyCount = 0;
+    capture.stopping = false;
+
+    const size_t bytes = static_cast<size_t>(size.x) * size.y * 4;
+    for (int i = 0; i < FrameCapture::SLOT_COUNT; i++) {
+        capture.slotPixels[i].resize(bytes);
+        capture.freeSlots[i] = i;
     }
-    
-    if (G.carPos > FINISH_LINE) {
-        G.carPos = FINISH_LINE;
-        G.carSpeed = 0.0f;
+    capture.freeCount = FrameCapture::SLOT_COUNT;
+
+    glGenBuffers(FrameCapture::PBO_COUNT, capture.pbos);
+    for (GLuint pbo : capture.pbos) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    nextCapturePath(format);
+    int workerCount = 1;
+    if (format == CaptureFormat::Png) {
+        std::error_code ec;
+        std::filesystem::create_directories(capture.path, ec);
+        workerCount = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    }
+    else {
+        capture.yuv = std::fopen(capture.path, "wb");
+    }
+    for (int i = 0; i < workerCount; i++) {
+        capture.workers.emplace_back(captureWorker);
     }
-    if (G.carPos < -45.0f) G.carPos = -45.0f;
-    
 
-    if (G.gameStarted) {
-     
-        G.car2Pos += G.car2Speed * dt;
-    
-        if (G.car2Pos >= FINISH_LINE && G.car2FinishPlace == 0) {
-            G.finishOrder++;
-            G.car2FinishPlace = G.finishOrder;
-            std::cout << "Black car finished in place: " << G.car2FinishPlace << "\n";
+    capture.active = true;
+    std::cout << "Recording " << size.x << "x" << size.y << " to " << capture.path
+              << (format == CaptureFormat::Png ? "/*.png\n" : " (yuv420p)\n");
+}
+
+static void retirePbo(int pbo) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.pbos[pbo]);
+    const void* pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (pixels) {
+        int slot = -1;
+        {
+            std::lock_guard<std::mutex> lock(capture.mutex);
+            if (capture.freeCount > 0) slot = capture.freeSlots[--capture.freeCount];
         }
-        
-        if (G.car2Pos > FINISH_LINE) {
-            G.car2Pos = FINISH_LINE;
-            G.car2Speed = 0.0f;
+        if (slot < 0) {
+            capture.dropped++;
         }
-        
-        G.car3Pos += G.car3Speed * dt;
-        
-        if (G.car3Pos >= FINISH_LINE && G.car3FinishPlace == 0) {
-            G.finishOrder++;
-            G.car3FinishPlace = G.finishOrder;
-            std::cout << "Green car finished in place: " << G.car3FinishPlace << "\n";
-        }
-        
-        if (G.car3Pos > FINISH_LINE) {
-            G.car3Pos = FINISH_LINE;
-            G.car3Speed = 0.0f;
+        else {
+            std::memcpy(capture.slotPixels[slot].data(), pixels, capture.slotPixels[slot].size());
+            capture.slotFrame[slot] = capture.queued++;
+            std::lock_guard<std::mutex> lock(capture.mutex);
+            const int tail = (capture.readyHead + capture.readyCount) % FrameCapture::SLOT_COUNT;
+            capture.ready[tail] = slot;
+            capture.readyCount++;
+            capture.cv.notify_one();
         }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
     }
+}
 
-    updateParticles(dt);
-    
-    if (G.gameStarted) {
-        spawnDustParticles(-1.0f, G.carPos, G.carSpeed);
-        spawnDustParticles(-3.0f, G.car2Pos, G.car2Speed);
-        spawnDustParticles(1.0f, G.car3Pos, G.car3Speed);
+static void captureFrame(sf::Vector2u size) {
+    if (size.x != capture.width || size.y != capture.height) {
+        capture.dropped++;
+        return;
     }
-}
-static void sceneCar()
-{
-    glUseProgram(shaderProgram);
-    
-    GLint lightPosLoc = glGetUniformLocation(shaderProgram, "lightPosition");
-       GLint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-       GLint shininessLoc = glGetUniformLocation(shaderProgram, "shininess");
-       
-       glUniform3f(lightPosLoc, 50.0f, 80.0f, 30.0f);
-       glUniform3f(lightColorLoc, 1.0f, 0.95f, 0.8f);
-       glUniform1f(shininessLoc, 128.0f);
-    
-    glPushMatrix();
-
-    glColor3f(0.8f, 0.0f, 0.0f);
-    setMaterial(128.0f);
-
-    drawBox(1.0f, 0.3f, 0.7f);
-
-    glPushMatrix();
-    glTranslatef(0.06, 0.3f, 0.0f);
-    drawBox(0.6f, 0.35f, 0.6f);
-    glPopMatrix();
-
-    const float wheelX = 0.5f;
-    const float wheelZ = 0.4;
-    const float wheelY = -0.10f;
-
-    auto drawOneWheel = [&](float x, float z) {
-        glPushMatrix();
-        glTranslatef(x, wheelY, z);
-        glRotatef(G.wheelAngle, 0, 0, 1);
-        drawWheel();
-        glPopMatrix();
-    };
-
-    drawOneWheel(+wheelX, +wheelZ);
-    drawOneWheel(+wheelX, -wheelZ);
-    drawOneWheel(-wheelX, +wheelZ);
-    drawOneWheel(-wheelX, -wheelZ);
-    
-    glUseProgram(0);
 
-    glPopMatrix();
+    const std::int64_t start = nowUs();
+    const int pbo = static_cast<int>(capture.issued % FrameCapture::PBO_COUNT);
+    if (capture.issued >= FrameCapture::PBO_COUNT) retirePbo(pbo);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.pbos[pbo]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, capture.width, capture.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    capture.issued++;
+    capture.readbackUs += nowUs() - start;
 }
 
-static void carMoving()
-{
-    glUseProgram(shaderProgram);
-
-        GLint lightPosLoc = glGetUniformLocation(shaderProgram, "lightPosition");
-        GLint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-        GLint shininessLoc = glGetUniformLocation(shaderProgram, "shininess");
-        
-        glUniform3f(lightPosLoc, 50.0f, 80.0f, 30.0f);
-        glUniform3f(lightColorLoc, 1.0f, 0.95f, 0.8f);
-        glUniform1f(shininessLoc, 64.0f);
-    
-    glPushMatrix();
-
-    glColor3f(0.0f, 0.0f, 0.0f);
-    setMaterial(50);
+static void stopCapture() {
+    const std::uint64_t first = capture.issued > FrameCapture::PBO_COUNT ? capture.issued - FrameCapture::PBO_COUNT : 0;
+    for (std::uint64_t i = first; i < capture.issued; i++) {
+        retirePbo(static_cast<int>(i % FrameCapture::PBO_COUNT));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteBuffers(FrameCapture::PBO_COUNT, capture.pbos);
 
-    drawBox(1.0f, 0.3f, 0.7f);
+    {
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        capture.stopping = true;
+    }
+    capture.cv.notify_all();
+    for (auto& t : capture.workers) t.join();
+    capture.workers.clear();
+    if (capture.yuv) {
+        std::fclose(capture.yuv);
+        capture.yuv = nullptr;
+        std::cout << "ffmpeg -f rawvideo -pix_fmt yuv420p -s " << (capture.width & ~1u) << "x"
+                  << (capture.height & ~1u) << " -r 60 -i " << capture.path << " race.mp4\n";
+    }
+    capture.active = false;
+
+    const double frames = capture.issued ? static_cast<double>(capture.issued) : 1.0;
+    std::printf("Capture: %llu frames encoded, %llu dropped, readback %.3f ms/frame\n",
+        (unsigned long long)capture.queued, (unsigned long long)capture.dropped,
+        capture.readbackUs / 1000.0 / frames);
+    if (capture.capturedFrames && capture.plainFrames) {
+        const double withCapture = capture.capturedFrameUs / 1000.0 / capture.capturedFrames;
+        const double without = capture.plainFrameUs / 1000.0 / capture.plainFrames;
+        std::printf("Frame time: %.3f ms recording vs %.3f ms without (+%.3f ms)\n",
+            withCapture, without, withCapture - without);
+    }
+}
 
-    glPushMatrix();
-    glTranslatef(0.06f, 0.3f, 0.0f);
-    drawBox(0.6f, 0.35f, 0.6f);
-    glPopMatrix();
+// Only racing frames are compared: the start screen and the results idle on
+// vsync and would dilute the frames-without-capture average.
+static void captureFrameTime(std::int64_t frameUs) {
+    if (!G.gameStarted || raceFinished()) return;
+    if (capture.active) {
+        capture.capturedFrameUs += frameUs;
+        capture.capturedFrames++;
+    }
+    else {
+        capture.plainFrameUs += frameUs;
+        capture.plainFrames++;
+    }
+}
 
-    const float wheelX = 0.5f;
-    const float wheelZ = 0.4f;
-    const float wheelY = -0.10f;
+static TelemetryRing* telemetry = nullptr;
+static std::uint64_t telemetryTick = 0;
+
+static void publishTelemetry(float dt, float frameMs) {
+    TelemetrySample t;
+    t.tick = telemetryTick++;
+    t.timeUs = nowUs();
+    t.dt = dt;
+    t.frameMs = frameMs;
+    t.raceStarted = G.gameStarted;
+    // Only the local player's nitro presses are known here.
+    for (int i = 0; i < 3; i++) {
+        t.cars[i] = { *carPosOf[i], *carSpeedOf[i], *carPlaceOf[i], i == G.localCar ? G.nitroUses : 0u };
+    }
+    telemetryPublish(telemetry, t);
+}
 
-    auto drawOneWheel = [&](float x, float z) {
-        glPushMatrix();
-        glTranslatef(x, wheelY, z);
-        glRotatef(G.wheelAngle, 0, 0, 1);
-        drawWheel();
-        glPopMatrix();
-    };
+enum class NetRole { None, Host, Client };
 
-    drawOneWheel(+wheelX, +wheelZ);
-    drawOneWheel(+wheelX, -wheelZ);
-    drawOneWheel(-wheelX, +wheelZ);
-    drawOneWheel(-wheelX, -wheelZ);
+static NetRole netRole = NetRole::None;
+static NetServer netServer;
+static NetClient netClient;
+static float netImpulse = 0.0f;
 
-    glPopMatrix();
+static NetRaceState gatherRaceState() {
+    NetRaceState s = {};
+    s.started = G.gameStarted;
+    for (int i = 0; i < 3; i++) {
+        s.cars[i] = { *carPosOf[i], *carSpeedOf[i], *carPlaceOf[i] };
+    }
+    return s;
 }
 
-static void drawGround(float size = 50.0f)
-{
-    glDisable(GL_LIGHTING);
-    glDisable(GL_COLOR_MATERIAL);
+static void applyImpulse(float dv) {
+    if (netRole == NetRole::Client) netImpulse += dv;
+    else G.carSpeed += dv;
+}
 
-    if (G.groundTexture) {
-        glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, G.groundTexture);
-        glColor3f(1.0f, 1.0f, 1.0f);
-    } else {
-        glColor3f(0.8f, 0.6f, 0.4f);
+static void netHostReceive(std::int64_t now) {
+    NetRaceState s = gatherRaceState();
+    netServer.poll(s, now);
+    for (int i = 1; i < 3; i++) {
+        G.carRemote[i] = netServer.remote(i);
+        if (!G.carRemote[i]) continue;
+        *carPosOf[i] = s.cars[i].pos;
+        *carSpeedOf[i] = s.cars[i].speed;
     }
+}
 
-    glBegin(GL_QUADS);
-    glNormal3f(0.0f, 1.0f, 0.0f);
-    
-    const float tiles = 25.0f;
-
-    glTexCoord2f(0, 0);       glVertex3f(-size, 0, -size);
-    glTexCoord2f(tiles, 0);   glVertex3f(+size, 0, -size);
-    glTexCoord2f(tiles, tiles); glVertex3f(+size, 0, +size);
-    glTexCoord2f(0, tiles);   glVertex3f(-size, 0, +size);
-    glEnd();
+static void netHostSend(std::int64_t now) {
+    NetRaceState s = gatherRaceState();
+    netServer.update(s, now);
+}
 
-    if (G.groundTexture) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDisable(GL_TEXTURE_2D);
+// Clients never run the race logic: their own car is predicted from local
+// inputs, the rest (including finish places) comes from server snapshots.
+static void netClientUpdate(float dt, std::int64_t now) {
+    netClient.sendInput(netImpulse, dt, now);
+    netImpulse = 0.0f;
+    netClient.poll(now);
+
+    if (netClient.rejected()) {
+        std::cout << "Gra bez sieci.\n";
+        netClient.close();
+        netRole = NetRole::None;
     }
-    
-    glEnable(GL_COLOR_MATERIAL);
-    glEnable(GL_LIGHTING);
+    else if (netClient.joined()) {
+        G.localCar = netClient.slot;
+        const NetRaceState s = netClient.view(now);
+        if (s.started && !G.gameStarted) {
+            G.gameStarted = true;
+            G.chaseCam = true;
+        }
+        for (int i = 0; i < 3; i++) {
+            *carPosOf[i] = s.cars[i].pos;
+            *carSpeedOf[i] = s.cars[i].speed;
+            *carPlaceOf[i] = s.cars[i].finishPlace;
+        }
+    }
+    updateDust(dt);
 }
 
-static void drawCactus(float height = 2.0f) {
-    glColor3f(0.2f, 0.6f, 0.2f);
+static void printNetReport() {
+    if (netRole == NetRole::Host) {
+        const std::uint64_t sent = netServer.fullSnapshots + netServer.deltaSnapshots;
+        std::printf("Net: %llu snapshots (%llu full), %.1f B avg, %llu B sent, %llu B received\n",
+            (unsigned long long)sent, (unsigned long long)netServer.fullSnapshots,
+            sent ? static_cast<double>(netServer.snapshotBytes) / sent : 0.0,
+            (unsigned long long)netServer.socket.stats.bytesSent,
+            (unsigned long long)netServer.socket.stats.bytesReceived);
+    }
+    else if (netRole == NetRole::Client) {
+        std::printf("Net: %llu snapshots, %llu undecodable, prediction correction avg %.3f max %.3f\n",
+            (unsigned long long)netClient.snapshots, (unsigned long long)netClient.undecodable,
+            netClient.snapshots ? netClient.correctionSum / netClient.snapshots : 0.0,
+            netClient.correctionMax);
+    }
+}
 
-    glPushMatrix();
-    glRotatef(-90, 1, 0, 0);
-    gluCylinder(gQuad, 0.15, 0.12, height, 16, 1);
-    glPopMatrix();
-    
-    glPushMatrix();
-    glTranslatef(-0.25f, height * 0.5f, 0);
-    glRotatef(-90, 1, 0, 0);
-    gluCylinder(gQuad, 0.1, 0.08, height * 0.4f, 12, 1);
-    glPopMatrix();
-    
-    glPushMatrix();
-    glTranslatef(0.25f, height * 0.6f, 0);
-    glRotatef(-90, 1, 0, 0);
-    gluCylinder(gQuad, 0.1, 0.08, height * 0.5f, 12, 1);
-    glPopMatrix();
-}
-
-static void drawStartPole(float height = 2.5f) {
-    glColor3f(1.0f, 0.8f, 0.0f);
-    glPushMatrix();
-    glRotatef(-90, 1, 0, 0);
-    gluCylinder(gQuad, 0.1, 0.1, height, 16, 1);
-    glPopMatrix();
-    glColor3f(1.0f, 0.0f, 0.0f);
-    glPushMatrix();
-    glTranslatef(0, height, 0);
-    glRotatef(90, 0, 1, 0);
-    glScalef(0.5f, 0.3f, 0.05f);
-    drawBox(1.0f, 1.0f, 1.0f);
-    glPopMatrix();
-}
-
-
-static void drawFinishLine(float zPos = 40.0f) {
-    glDisable(GL_LIGHTING);
-    glLineWidth(5.0f);
-    glBegin(GL_LINES);
-    glColor3f(1.0f, 0.0f, 0.0f);
-    glVertex3f(-5.0f, 0.01f, zPos);
-    glVertex3f(5.0f, 0.01f, zPos);
-    glEnd();
-    glEnable(GL_LIGHTING);
-}
-
-static void drawRoad() {
-    glDisable(GL_LIGHTING);
-    
-    glColor3f(0.2f, 0.2f, 0.2f);
-    glBegin(GL_QUADS);
-    glVertex3f(-4.5f, 0.005f, -50.0f);
-    glVertex3f(2.5f, 0.005f, -50.0f);
-    glVertex3f(2.5f, 0.005f, 1200.0f);
-    glVertex3f(-4.5f, 0.005f, 1200.0f);
-    glEnd();
-    
-    glColor3f(1.0f, 1.0f, 1.0f);
-    glLineWidth(3.0f);
-    for (float z = -50.0f; z < 1200.0f; z += 8.0f) {
-        glBegin(GL_LINES);
-        glVertex3f(-1.0f, 0.01f, z);
-        glVertex3f(-1.0f, 0.01f, z + 4.0f);
-        glEnd();
+// Renders a mid-race frame with 1..4 views and reports the cost of each
+// layout relative to the single-view frame.
+static void runViewBenchmark(sf::RenderWindow& win) {
+    win.setVerticalSyncEnabled(false);
+    G.gameStarted = true;
+    G.chaseCam = true;
+    G.carPos = 200.0f;
+    G.car2Pos = 260.0f;
+    G.car3Pos = 320.0f;
+
+    const int warmup = 20;
+    const int frames = 300;
+    double singleMs = 0.0;
+    for (int n = 1; n <= 4; n++) {
+        setViewCount(n);
+        for (int i = 0; i < warmup; i++) {
+            prepareFrame(1.0f / 60.0f, win.getSize().x, win.getSize().y);
+            renderFrame(win.getSize().x, win.getSize().y);
+            win.display();
+            frameArena.reset();
+        }
+        glFinish();
+
+        terrainTriangles = 0;
+        sf::Clock timer;
+        for (int i = 0; i < frames; i++) {
+            prepareFrame(1.0f / 60.0f, win.getSize().x, win.getSize().y);
+            renderFrame(win.getSize().x, win.getSize().y);
+            win.display();
+            frameArena.reset();
+        }
+        glFinish();
+        const double ms = timer.getElapsedTime().asMicroseconds() / 1000.0 / frames;
+        if (n == 1) singleMs = ms;
+        std::printf("%d view(s): %7.3f ms/frame  %.2fx single view (naive: %dx)  terrain %ld tris/frame\n",
+            n, ms, ms / singleMs, n, terrainTriangles / frames);
     }
-    
-    glColor3f(1.0f, 0.9f, 0.0f);
-    glLineWidth(4.0f);
-    glBegin(GL_LINES);
-    glVertex3f(-4.3f, 0.01f, -50.0f);
-    glVertex3f(-4.3f, 0.01f, 1200.0f);
-    glVertex3f(2.3f, 0.01f, -50.0f);
-    glVertex3f(2.3f, 0.01f, 1200.0f);
-    glEnd();
-    
-    glEnable(GL_LIGHTING);
 }
 
+static const char* const QUALITY_CONFIG_PATH = "carrace_quality.cfg";
 
-static void drawSceneObjects() {
+static sf::Vector2u fitToDesktop(unsigned w, unsigned h) {
+    const sf::Vector2u desktop = sf::VideoMode::getDesktopMode().size;
+    return { std::min(w, desktop.x), std::min(h, desktop.y) };
+}
 
-    for (int i = 0; i < 2500; i++) {
-        float z = i * 4.0f - 50.0f;
-        
-        glPushMatrix();
-        glTranslatef(-5.5f, 0.0f, z);
-        drawCactus(1.0f + (i % 4) * 0.3f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(-7.5f - (i % 2) * 1.0f, 0.0f, z + 1.5f);
-        drawCactus(1.3f + (i % 3) * 0.4f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(-10.0f - (i % 3) * 1.5f, 0.0f, z + 0.5f);
-        drawCactus(1.1f + (i % 5) * 0.3f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(-13.0f - (i % 4) * 2.0f, 0.0f, z + 2.0f);
-        drawCactus(1.4f + (i % 4) * 0.5f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(-16.0f - (i % 2) * 1.0f, 0.0f, z + 1.0f);
-        drawCactus(1.2f + (i % 3) * 0.3f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(-19.0f - (i % 5) * 1.5f, 0.0f, z + 2.5f);
-        drawCactus(1.5f + (i % 4) * 0.4f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(3.5f, 0.0f, z + 0.8f);
-        drawCactus(1.1f + (i % 5) * 0.4f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(5.5f + (i % 2) * 1.0f, 0.0f, z + 2.2f);
-        drawCactus(1.2f + (i % 4) * 0.3f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(8.0f + (i % 3) * 1.5f, 0.0f, z + 1.3f);
-        drawCactus(1.3f + (i % 3) * 0.5f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(11.0f + (i % 4) * 2.0f, 0.0f, z + 0.7f);
-        drawCactus(1.0f + (i % 5) * 0.4f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(14.0f + (i % 2) * 1.0f, 0.0f, z + 2.8f);
-        drawCactus(1.4f + (i % 3) * 0.3f);
-        glPopMatrix();
-        
-        glPushMatrix();
-        glTranslatef(17.0f + (i % 5) * 1.5f, 0.0f, z + 1.5f);
-        drawCactus(1.2f + (i % 4) * 0.5f);
-        glPopMatrix();
+static sf::Vector2u calibrationSize() {
+    unsigned w = 0, h = 0;
+    for (const QualityPreset& q : qualityPresets) {
+        w = std::max(w, q.windowWidth);
+        h = std::max(h, q.windowHeight);
     }
-    
-    drawFinishLine(800.0f);
-    
-    glPushMatrix();
-    glTranslatef(-4.5f, 0.0f, -40.0f);
-    drawStartPole(2.5f);
-    glPopMatrix();
-    
-    glPushMatrix();
-    glTranslatef(2.5f, 0.0f, -40.0f);
-    drawStartPole(2.5f);
-    glPopMatrix();
-    
-    glPushMatrix();
-    glTranslatef(-4.5f, 0.0f, 150.0f);
-    drawStartPole(3.0f);
-    glPopMatrix();
-    
-    glPushMatrix();
-    glTranslatef(2.5f, 0.0f, 150.0f);
-    drawStartPole(3.0f);
-    glPopMatrix();
+    return fitToDesktop(w, h);
 }
-static void drawScene(float dt) {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
 
-    if (G.chaseCam == false) {
-        glRotatef(G.rotX, 1, 0, 0);
-        glRotatef(G.rotY, 0, 1, 0);
-    }
-    drawSky(200.0f);
-    glPopMatrix();
-    
-    setupView();
+// Renders the mid-race chase view at each preset's settings and resolution,
+// cheapest first, with vsync off and a glFinish per frame so the times
+// include the GPU. Stops at the first preset that misses the target frame
+// rate: the ones above it only cost more. Events are drained every frame so
+// the window stays responsive and nothing typed meanwhile reaches the race;
+// returns false if the window was closed.
+static bool calibrateQuality(sf::RenderWindow& win, QualityConfig& config) {
+    const int warmup = 10;
+    const int frames = 90;
+    const std::int64_t presetBudgetUs = 1000000;
+    const float targetMs = 1000.0f / config.targetFps;
+    const AppState saved = G;
+    clearQualityMeasurements(config);
+
+    std::printf("Calibrating quality for %.0f fps...\n", config.targetFps);
+    win.setSize(calibrationSize());
+    win.setVerticalSyncEnabled(false);
+    G.gameStarted = true;
+    G.chaseCam = true;
+    setViewCount(1);
+
+    bool open = true;
+    std::vector<float> ms;
+    ms.reserve(frames);
+    for (int p = 0; p < QUALITY_PRESETS && open; p++) {
+        const QualityPreset& q = qualityPresets[p];
+        applyQuality(q);
+        const int w = static_cast<int>(std::min(q.windowWidth, win.getSize().x));
+        const int h = static_cast<int>(std::min(q.windowHeight, win.getSize().y));
+
+        ms.clear();
+        const std::int64_t start = nowUs();
+        for (int i = 0; i < warmup + frames && nowUs() - start < presetBudgetUs && open; i++) {
+            while (const std::optional<sf::Event> event = win.pollEvent()) {
+                if (event->is<sf::Event::Closed>()) open = false;
+            }
+            const std::int64_t t0 = nowUs();
+            G.carPos = 200.0f;
+            G.car2Pos = 195.0f;
+            G.car3Pos = 205.0f;
+            G.carSpeed = 40.0f;
+            updateDust(1.0f / 60.0f);
+            prepareFrame(1.0f / 60.0f, w, h);
+            renderFrame(w, h);
+            glFinish();
+            win.display();
+            frameArena.reset();
+            if (i >= warmup) ms.push_back((nowUs() - t0) / 1000.0f);
+        }
 
-    if (G.chaseCam == false) {
-        glRotatef(G.rotX, 1, 0, 0);
-        glRotatef(G.rotY, 0, 1, 0);
+        summarizeFrameTimes(ms.data(), static_cast<int>(ms.size()), config.meanMs[p], config.p95Ms[p]);
+        std::printf("  %-6s %4dx%-4d %7.2f ms mean  %7.2f ms p95  (%zu frames)\n",
+            q.name, w, h, config.meanMs[p], config.p95Ms[p], ms.size());
+        if (ms.empty() || config.p95Ms[p] > targetMs) break;
     }
 
-    drawGround(1300.0f);
-    drawRoad();
-    
-    glPushMatrix();
-    glTranslatef(-1.0f, 0.01f, G.carPos);
-    sceneCar();
-    glPopMatrix();
-
-    glPushMatrix();
-    glTranslatef(-3.0f, 0.01f, G.car2Pos);
-    carMoving();
-    glPopMatrix();
-
-
-    glPushMatrix();
-    glTranslatef(1.0f, 0.01f, G.car3Pos);
-    glUseProgram(shaderProgram);
-
-    GLint lightPosLoc = glGetUniformLocation(shaderProgram, "lightPosition");
-    GLint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLint shininessLoc = glGetUniformLocation(shaderProgram, "shininess");
-
-    glUniform3f(lightPosLoc, 50.0f, 80.0f, 30.0f);
-    glUniform3f(lightColorLoc, 1.0f, 0.95f, 0.8f);
-    glUniform1f(shininessLoc, 96.0f);
-
-    glColor3f(0.0f, 0.8f, 0.0f);
-    setMaterial(96);
-
-    drawBox(1.0f, 0.3f, 0.7f);
-
-    glPushMatrix();
-    glTranslatef(0.06f, 0.3f, 0.0f);
-    drawBox(0.6f, 0.35f, 0.6f);
-    glPopMatrix();
-
-    const float wheelX = 0.5f;
-    const float wheelZ = 0.4f;
-    const float wheelY = -0.10f;
-
-    auto drawOneWheel = [&](float x, float z) {
-        glPushMatrix();
-        glTranslatef(x, wheelY, z);
-        glRotatef(G.wheelAngle, 0, 0, 1);
-        drawWheel();
-        glPopMatrix();
-    };
-
-    drawOneWheel(+wheelX, +wheelZ);
-    drawOneWheel(+wheelX, -wheelZ);
-    drawOneWheel(-wheelX, +wheelZ);
-    drawOneWheel(-wheelX, -wheelZ);
-
-    glUseProgram(0);
-    glPopMatrix();
-    
+    config.preset = pickQualityPreset(config);
+    config.calibrated = true;
+    G = saved;
+    particles.clear();
+    win.setVerticalSyncEnabled(true);
+    return open;
+}
 
-    drawSceneObjects();
-    
+int main(int argc, char** argv) {
+    bool benchViews = false;
+    bool recordOnStart = false;
+    CaptureFormat recordFormat = CaptureFormat::Png;
+    std::uint16_t netPort = NET_DEFAULT_PORT;
+    const char* netAddress = "127.0.0.1";
+    int tickRate = 30;
+    float netLoss = 0.0f;
+    int netLatency = 0;
+    const char* heightmapPath = nullptr;
+    int qualityOverride = -1;
+    bool recalibrate = false;
+    float targetFps = 0.0f;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--low-latency") == 0) pacer.lowLatency = true;
+        if (std::strcmp(argv[i], "--bench-views") == 0) benchViews = true;
+        if (std::strcmp(argv[i], "--alloc-trace") == 0) allocReport.trace = true;
+        if (std::strcmp(argv[i], "--host") == 0) {
+            netRole = NetRole::Host;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0) netPort = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        }
+        if (std::strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            netRole = NetRole::Client;
+            netAddress = argv[++i];
+        }
+        if (std::strcmp(argv[i], "--particle-blend") == 0 && i + 1 < argc) {
+            particleBlend = std::strcmp(argv[++i], "additive") == 0 ? ParticleBlend::Additive : ParticleBlend::Sorted;
+        }
+        if (std::strcmp(argv[i], "--heightmap") == 0 && i + 1 < argc) heightmapPath = argv[++i];
+        if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) tickRate = std::atoi(argv[++i]);
+        if (std::strcmp(argv[i], "--net-loss") == 0 && i + 1 < argc) netLoss = static_cast<float>(std::atof(argv[++i]));
+        if (std::strcmp(argv[i], "--net-latency") == 0 && i + 1 < argc) netLatency = std::atoi(argv[++i]);
+        if (std::strcmp(argv[i], "--telemetry") == 0) {
+            telemetry = telemetryCreate();
+            if (!telemetry) std::cout << "Nie można utworzyć pamięci współdzielonej telemetrii!\n";
+        }
+        if (std::strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+            qualityOverride = qualityPresetByName(argv[++i]);
+            if (qualityOverride < 0) std::cout << "Nieznany poziom jakości: " << argv[i] << "\n";
+        }
+        if (std::strcmp(argv[i], "--recalibrate") == 0) recalibrate = true;
+        if (std::strcmp(argv[i], "--target-fps") == 0 && i + 1 < argc) targetFps = static_cast<float>(std::atof(argv[++i]));
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordOnStart = true;
+            recordFormat = std::strcmp(argv[++i], "yuv") == 0 ? CaptureFormat::Yuv : CaptureFormat::Png;
+        }
+    }
 
-    drawParticles(gQuad);
-}
+    QualityConfig quality;
+    const bool haveQualityConfig = loadQualityConfig(QUALITY_CONFIG_PATH, quality);
+    if (targetFps > 0.0f) quality.targetFps = targetFps;
+    bool calibrate = qualityOverride < 0 && (recalibrate || !haveQualityConfig || !quality.calibrated);
+    if (qualityOverride >= 0) quality.preset = qualityOverride;
 
-int main() {
-    sf::RenderWindow win(sf::VideoMode({1024, 768}), "3D car race");
+    const QualityPreset& startPreset = qualityPresets[quality.preset];
+    sf::RenderWindow win(sf::VideoMode(calibrate ? calibrationSize()
+        : fitToDesktop(startPreset.windowWidth, startPreset.windowHeight)), "3D car race");
 
     win.setVerticalSyncEnabled(true);
     (void)win.setActive(true);
@@ -805,25 +894,23 @@ int main() {
     initOpenGL();
     initLighting();
     setMaterial(100);
-    setupProjection(win.getSize());
     initQuadric();
     initParticles();
+    initTerrain(heightmapPath);
+    initTerrainMesh();
+    initSceneObjects();
+    setViewCount(1);
     
     initShaders();
+    initCarScene();
     
     sf::Font font;
     if (!font.openFromFile("/System/Library/Fonts/Supplemental/Arial.ttf")) {
         std::cout << "Nie mozna wczytac czcionki!\n";
     }
 
-    sf::Text startText(font, "Press SPACE to start the race!", 30);
-    startText.setFillColor(sf::Color::White);
-    startText.setPosition({300.f, 50.f});
-    
-    sf::Text controlsText(font, "W - Forward  |  S - Backward  |  Q - Nitro", 20);
-    controlsText.setFillColor(sf::Color::White);
-    controlsText.setPosition({10.f, 720.f});
-    
+    Hud hud(font);
+
     sf::Image img;
     if (!img.loadFromFile("sky.jpg")) {
         std::cout << "Nie można wczytać tekstury nieba!\n";
@@ -834,6 +921,7 @@ int main() {
     else {
         glGenTextures(1, &G.skyTexture);
         glBindTexture(GL_TEXTURE_2D, G.skyTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img.getSize().x, img.getSize().y, 0,
             GL_RGBA, GL_UNSIGNED_BYTE, img.getPixelsPtr());
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -841,13 +929,88 @@ int main() {
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    // Measurements from a different GL driver or GPU say nothing about this one.
+    const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    if (qualityOverride < 0 && renderer && quality.renderer != renderer) calibrate = true;
+    // A new --target-fps re-picks from the stored measurements. Calibration
+    // stops at the first preset that misses its target, so if even that one
+    // fits the new target the presets above it were never measured.
+    if (targetFps > 0.0f && qualityOverride < 0 && !calibrate) {
+        int measured = -1;
+        for (int i = 0; i < QUALITY_PRESETS; i++) {
+            if (quality.p95Ms[i] > 0.0f) measured = i;
+        }
+        if (measured < 0 || (measured + 1 < QUALITY_PRESETS && quality.p95Ms[measured] <= 1000.0f / targetFps)) {
+            calibrate = true;
+        }
+        else {
+            quality.preset = pickQualityPreset(quality);
+            if (!saveQualityConfig(QUALITY_CONFIG_PATH, quality)) {
+                std::cout << "Nie można zapisać " << QUALITY_CONFIG_PATH << "!\n";
+            }
+        }
+    }
+    if (calibrate) {
+        if (!calibrateQuality(win, quality)) {
+            freeSceneObjects();
+            freeQuadric();
+            return 0;
+        }
+        quality.renderer = renderer ? renderer : "";
+        if (!saveQualityConfig(QUALITY_CONFIG_PATH, quality)) {
+            std::cout << "Nie można zapisać " << QUALITY_CONFIG_PATH << "!\n";
+        }
+    }
+    const QualityPreset& preset = qualityPresets[quality.preset];
+    applyQuality(preset);
+    const sf::Vector2u presetSize = fitToDesktop(preset.windowWidth, preset.windowHeight);
+    if (win.getSize().x != presetSize.x || win.getSize().y != presetSize.y) {
+        win.setSize(presetSize);
+        win.setView(sf::View(sf::FloatRect({ 0.0f, 0.0f }, { static_cast<float>(presetSize.x), static_cast<float>(presetSize.y) })));
+    }
+    std::printf("Quality: %s (%ux%u)\n", preset.name, presetSize.x, presetSize.y);
+
+    if (benchViews) {
+        runViewBenchmark(win);
+        freeSceneObjects();
+        freeQuadric();
+        return 0;
+    }
+
+    if (recordOnStart) startCapture(win.getSize(), recordFormat);
+
+    if (netRole == NetRole::Host) {
+        if (netServer.open(netPort, tickRate)) {
+            std::cout << "Hosting on UDP port " << netPort << " at " << tickRate << " Hz\n";
+        }
+        else {
+            std::cout << "Nie można otworzyć portu " << netPort << "!\n";
+            netRole = NetRole::None;
+        }
+        netServer.socket.lossPercent = netLoss;
+        netServer.socket.latencyMs = netLatency;
+    }
+    else if (netRole == NetRole::Client) {
+        if (!netClient.connect(netAddress, nowUs())) {
+            std::cout << "Nie można połączyć z " << netAddress << "!\n";
+            netRole = NetRole::None;
+        }
+        netClient.socket.lossPercent = netLoss;
+        netClient.socket.latencyMs = netLatency;
+    }
+
     sf::Clock clock;
+    float lastFrameMs = 0.0f;
     
 
+    std::int64_t inputSinceUs = nowUs();
     bool running = true;
     while (running) {
+        waitForInputDeadline();
+        const std::int64_t frameStartUs = nowUs();
         float dt = clock.restart().asSeconds();
 
+        allocTag = AllocTag::Input;
         for (std::optional<sf::Event> event = win.pollEvent(); event.has_value(); event = win.pollEvent()) {
             sf::Event e = event.value();
             
@@ -859,10 +1022,6 @@ int main() {
                 running = false;
             }
             
-            if (e.is<sf::Event::Resized>()) {
-                setupProjection(win.getSize());
-            }
-
             if (e.is<sf::Event::KeyPressed>()) {
                 sf::Keyboard::Key code = e.getIf<sf::Event::KeyPressed>()->code;
                 switch (code) {
@@ -870,16 +1029,20 @@ int main() {
                 case sf::Keyboard::Key::Right:    if (!G.chaseCam) G.rotY += 5.f; break;
                 case sf::Keyboard::Key::Up:       if (!G.chaseCam) G.rotX += 5.f; break;
                 case sf::Keyboard::Key::Down:     if (!G.chaseCam) G.rotX -= 5.f; break;
-                case sf::Keyboard::Key::W: G.carSpeed += 2.5f; break;
-                case sf::Keyboard::Key::S: G.carSpeed -= 2.0; break;
-                case sf::Keyboard::Key::Q: G.carSpeed += 20.0f; break;
+                case sf::Keyboard::Key::W: applyImpulse(2.5f); latencyInput(inputSinceUs); break;
+                case sf::Keyboard::Key::S: applyImpulse(-2.0f); latencyInput(inputSinceUs); break;
+                case sf::Keyboard::Key::Q: applyImpulse(20.0f); G.nitroUses++; latencyInput(inputSinceUs); break;
+                case sf::Keyboard::Key::L:
+                    pacer.lowLatency = !pacer.lowLatency;
+                    std::cout << "Low-latency pacing: " << (pacer.lowLatency ? "ON" : "OFF") << "\n";
+                    break;
                 case sf::Keyboard::Key::PageUp:
                 case sf::Keyboard::Key::P:
                     G.eye.x *= 0.95f;
                     G.eye.z *= 0.95f;
                     break;
                     case sf::Keyboard::Key::Space:
-                        if (!G.gameStarted) {
+                        if (!G.gameStarted && netRole != NetRole::Client) {
                             G.gameStarted = true;
                             G.chaseCam = true;
                             std::cout << "START: Race started!\n";
@@ -894,74 +1057,66 @@ int main() {
                 case sf::Keyboard::Key::C:
                     G.chaseCam = !G.chaseCam;
                     break;
+                case sf::Keyboard::Key::V:
+                    setViewCount(frame.viewCount % 4 + 1);
+                    break;
+                case sf::Keyboard::Key::B:
+                    particleBlend = particleBlend == ParticleBlend::Sorted ? ParticleBlend::Additive : ParticleBlend::Sorted;
+                    std::cout << "Particle blending: " << (particleBlend == ParticleBlend::Sorted ? "sorted" : "additive") << "\n";
+                    break;
+                case sf::Keyboard::Key::R:
+                    if (capture.active) stopCapture();
+                    else startCapture(win.getSize(), recordFormat);
+                    break;
                 default: break;
                 }
             }
         }
+        inputSinceUs = nowUs();
 
-        updateCarMovement(dt);
-        drawScene(dt);
-        
-        if (!G.gameStarted) {
-            win.pushGLStates();
-            win.draw(startText);
-            win.popGLStates();
+        allocTag = AllocTag::Simulation;
+        if (netRole == NetRole::Client) {
+            netClientUpdate(dt, nowUs());
         }
-        
-        if (G.gameStarted && !(G.carPos >= 800.0f && G.car2Pos >= 800.0f && G.car3Pos >= 800.0f)) {
-            win.pushGLStates();
-            win.draw(controlsText);
-            win.popGLStates();
+        else {
+            if (netRole == NetRole::Host) netHostReceive(nowUs());
+            updateCarMovement(dt);
+            if (netRole == NetRole::Host) netHostSend(nowUs());
         }
+        latencySimulated();
+        if (telemetry) publishTelemetry(dt, lastFrameMs);
+        allocTag = AllocTag::Render;
+        prepareFrame(dt, win.getSize().x, win.getSize().y);
+        renderFrame(win.getSize().x, win.getSize().y);
         
-        if (G.gameStarted && G.carPos >= 800.0f && G.car2Pos >= 800.0f && G.car3Pos >= 800.0f) {
-            sf::Text winText(font, "", 60);
-            winText.setFillColor(sf::Color::Yellow);
-            winText.setPosition({250.f, 250.f});
-
-            if (G.carFinishPlace == 1) {
-                winText.setString("YOU WIN!");
-                winText.setFillColor(sf::Color::Red);
-            }
-            else {
-                winText.setString("YOU LOSE!");
-                winText.setFillColor(sf::Color::White);
-            }
-            
-            win.pushGLStates();
-            win.draw(winText);
-            win.popGLStates();
-            
-            sf::Text rankingText(font, "", 30);
-            rankingText.setFillColor(sf::Color::White);
-            rankingText.setPosition({300.f, 350.f});
-            
-            std::vector<std::pair<std::string, int>> results = {
-                {"Red Car (YOU)", G.carFinishPlace},
-                {"Black Car", G.car2FinishPlace},
-                {"Green Car", G.car3FinishPlace}
-            };
-            
-            std::sort(results.begin(), results.end(),
-                [](const auto& a, const auto& b) { return a.second < b.second; });
-            
-            std::string ranking = "FINAL RESULTS:\n\n";
-            ranking += "1st: " + results[0].first + "\n";
-            ranking += "2nd: " + results[1].first + "\n";
-            ranking += "3rd: " + results[2].first;
-            
-            rankingText.setString(ranking);
-            
-            win.pushGLStates();
-            win.draw(rankingText);
-            win.popGLStates();
-        }
+        allocTag = AllocTag::Hud;
+        updateHud(hud, nowUs());
+        drawHud(win, hud);
 
-        
+        allocTag = AllocTag::Present;
+        if (capture.active) captureFrame(win.getSize());
+        const std::int64_t submitUs = nowUs();
         win.display();
-
+        const std::int64_t presentUs = nowUs();
+        latencyPresented(presentUs);
+        pacerFrameDone(frameStartUs, submitUs, presentUs);
+        captureFrameTime(presentUs - frameStartUs);
+        lastFrameMs = (presentUs - frameStartUs) / 1000.0f;
+
+        allocTag = AllocTag::Other;
+        frameArena.reset();
+        allocFrameEnd();
     }
 
+    if (capture.active) stopCapture();
+    telemetryDestroy(telemetry);
+    printNetReport();
+    netServer.close();
+    netClient.close();
+    printLatencyReport();
+    printAllocReport();
+    printArenaReport(frameArena);
+    freeSceneObjects();
     freeQuadric();
     return 0;
 }
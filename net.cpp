@@ -0,0 +1,472 @@
+#include "net.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    enum PacketType : std::uint8_t { Hello = 1, Welcome = 2, InputPacket = 3, Snapshot = 4 };
+
+    const int INPUT_REDUNDANCY = 8;
+    const std::int64_t CLIENT_TIMEOUT_US = 5000000;
+    const std::int64_t HELLO_INTERVAL_US = 250000;
+
+    struct Writer {
+        std::uint8_t* data;
+        int len;
+
+        void u8(std::uint8_t v) { data[len++] = v; }
+        void u16(std::uint16_t v) { u8(v & 0xff); u8(v >> 8); }
+        void u32(std::uint32_t v) { u16(v & 0xffff); u16(v >> 16); }
+        void var(std::int32_t v) {
+            std::uint32_t z = (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+            while (z >= 0x80) {
+                u8(static_cast<std::uint8_t>(z | 0x80));
+                z >>= 7;
+            }
+            u8(static_cast<std::uint8_t>(z));
+        }
+    };
+
+    struct Reader {
+        const std::uint8_t* data;
+        int len;
+        int pos = 0;
+        bool ok = true;
+
+        std::uint8_t u8() {
+            if (pos >= len) { ok = false; return 0; }
+            return data[pos++];
+        }
+        std::uint16_t u16() { std::uint16_t lo = u8(); return static_cast<std::uint16_t>(lo | (u8() << 8)); }
+        std::uint32_t u32() { std::uint32_t lo = u16(); return lo | (static_cast<std::uint32_t>(u16()) << 16); }
+        std::int32_t var() {
+            std::uint32_t z = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                const std::uint8_t b = u8();
+                z |= static_cast<std::uint32_t>(b & 0x7f) << shift;
+                if (!(b & 0x80)) break;
+            }
+            return static_cast<std::int32_t>((z >> 1) ^ (~(z & 1) + 1));
+        }
+    };
+
+    bool sameAddr(const sockaddr_in& a, const sockaddr_in& b) {
+        return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+    }
+
+    // Field layout of the snapshot change mask.
+    const int MASK_STARTED = 1 << 0;
+    int maskPos(int car) { return 1 << (1 + car); }
+    int maskSpeed(int car) { return 1 << (1 + NET_CARS + car); }
+    int maskPlace(int car) { return 1 << (1 + 2 * NET_CARS + car); }
+
+    void writeDelta(Writer& w, const NetQuantized& base, const NetQuantized& q) {
+        std::uint16_t mask = 0;
+        if (q.started != base.started) mask |= MASK_STARTED;
+        for (int i = 0; i < NET_CARS; i++) {
+            if (q.pos[i] != base.pos[i]) mask |= maskPos(i);
+            if (q.speed[i] != base.speed[i]) mask |= maskSpeed(i);
+            if (q.place[i] != base.place[i]) mask |= maskPlace(i);
+        }
+        w.u16(mask);
+        if (mask & MASK_STARTED) w.u8(q.started);
+        for (int i = 0; i < NET_CARS; i++) {
+            if (mask & maskPos(i)) w.var(q.pos[i] - base.pos[i]);
+            if (mask & maskSpeed(i)) w.var(q.speed[i] - base.speed[i]);
+            if (mask & maskPlace(i)) w.u8(q.place[i]);
+        }
+    }
+
+    NetQuantized readDelta(Reader& r, const NetQuantized& base) {
+        NetQuantized q = base;
+        const std::uint16_t mask = r.u16();
+        if (mask & MASK_STARTED) q.started = r.u8();
+        for (int i = 0; i < NET_CARS; i++) {
+            if (mask & maskPos(i)) q.pos[i] = static_cast<std::uint16_t>(base.pos[i] + r.var());
+            if (mask & maskSpeed(i)) q.speed[i] = static_cast<std::int16_t>(base.speed[i] + r.var());
+            if (mask & maskPlace(i)) q.place[i] = r.u8();
+        }
+        return q;
+    }
+
+    std::int16_t quantizeImpulse(float v) {
+        return static_cast<std::int16_t>(std::max(-32768.0f, std::min(32767.0f, std::round(v * 64.0f))));
+    }
+}
+
+void netStepCar(NetCar& car, float impulse, float dt, bool started) {
+    car.speed += impulse;
+    if (started) car.pos += car.speed * dt;
+    car.speed *= std::pow(0.95f, dt * 60.0f);
+
+    if (car.pos > NET_FINISH_LINE) {
+        car.pos = NET_FINISH_LINE;
+        car.speed = 0.0f;
+    }
+    if (car.pos < -45.0f) car.pos = -45.0f;
+}
+
+NetQuantized netQuantize(const NetRaceState& s) {
+    NetQuantized q;
+    q.tick = s.tick;
+    q.started = s.started ? 1 : 0;
+    for (int i = 0; i < NET_CARS; i++) {
+        const float pos = std::round((s.cars[i].pos + 64.0f) * 64.0f);
+        const float speed = std::round(s.cars[i].speed * 32.0f);
+        q.pos[i] = static_cast<std::uint16_t>(std::max(0.0f, std::min(65535.0f, pos)));
+        q.speed[i] = static_cast<std::int16_t>(std::max(-32768.0f, std::min(32767.0f, speed)));
+        q.place[i] = static_cast<std::uint8_t>(s.cars[i].finishPlace);
+    }
+    return q;
+}
+
+NetRaceState netDequantize(const NetQuantized& q) {
+    NetRaceState s;
+    s.tick = q.tick;
+    s.started = q.started != 0;
+    for (int i = 0; i < NET_CARS; i++) {
+        s.cars[i].pos = q.pos[i] / 64.0f - 64.0f;
+        s.cars[i].speed = q.speed[i] / 32.0f;
+        s.cars[i].finishPlace = q.place[i];
+    }
+    return s;
+}
+
+bool NetSocket::open(std::uint16_t port) {
+    fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void NetSocket::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    delayedCount = 0;
+}
+
+void NetSocket::transmit(const sockaddr_in& to, const std::uint8_t* data, int len) {
+    ::sendto(fd, data, len, 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+}
+
+void NetSocket::sendTo(const sockaddr_in& to, const std::uint8_t* data, int len, std::int64_t nowUs) {
+    stats.bytesSent += len;
+    stats.packetsSent++;
+
+    if (lossPercent > 0.0f) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        if ((rng % 10000) < static_cast<std::uint32_t>(lossPercent * 100.0f)) {
+            stats.packetsLost++;
+            return;
+        }
+    }
+
+    if (latencyMs <= 0 || delayedCount == MAX_DELAYED || len > MAX_PACKET) {
+        transmit(to, data, len);
+        return;
+    }
+
+    Delayed& d = delayed[(delayedHead + delayedCount) % MAX_DELAYED];
+    d.dueUs = nowUs + latencyMs * 1000;
+    d.to = to;
+    d.len = len;
+    std::memcpy(d.data, data, len);
+    delayedCount++;
+}
+
+void NetSocket::flush(std::int64_t nowUs) {
+    while (delayedCount > 0 && delayed[delayedHead].dueUs <= nowUs) {
+        const Delayed& d = delayed[delayedHead];
+        transmit(d.to, d.data, d.len);
+        delayedHead = (delayedHead + 1) % MAX_DELAYED;
+        delayedCount--;
+    }
+}
+
+int NetSocket::receive(sockaddr_in& from, std::uint8_t* buf, int cap) {
+    socklen_t fromLen = sizeof(from);
+    const ssize_t n = ::recvfrom(fd, buf, cap, 0, reinterpret_cast<sockaddr*>(&from), &fromLen);
+    if (n < 0) return -1;
+    stats.bytesReceived += n;
+    stats.packetsReceived++;
+    return static_cast<int>(n);
+}
+
+bool netResolve(const char* hostPort, sockaddr_in& out) {
+    std::string host = hostPort;
+    std::string port = std::to_string(NET_DEFAULT_PORT);
+    const size_t colon = host.rfind(':');
+    if (colon != std::string::npos) {
+        port = host.substr(colon + 1);
+        host.resize(colon);
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* res = nullptr;
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || !res) return false;
+    std::memcpy(&out, res->ai_addr, sizeof(out));
+    ::freeaddrinfo(res);
+    return true;
+}
+
+bool NetServer::open(std::uint16_t port, int tickRate) {
+    tickUs = 1000000 / std::max(1, tickRate);
+    tick = 0;
+    nextTickUs = 0;
+    return socket.open(port);
+}
+
+void NetServer::close() {
+    socket.close();
+    for (Client& c : clients) c.connected = false;
+}
+
+void NetServer::poll(NetRaceState& state, std::int64_t nowUs) {
+    socket.flush(nowUs);
+
+    std::uint8_t buf[NetSocket::MAX_PACKET];
+    sockaddr_in from;
+    int len;
+    while ((len = socket.receive(from, buf, sizeof(buf))) > 0) {
+        Reader r{ buf, len };
+        const std::uint8_t type = r.u8();
+
+        int slot = -1;
+        for (int i = 0; i < NET_CARS - 1; i++) {
+            if (clients[i].connected && sameAddr(clients[i].addr, from)) slot = i;
+        }
+
+        if (type == Hello) {
+            if (slot < 0) {
+                for (int i = 0; i < NET_CARS - 1 && slot < 0; i++) {
+                    if (clients[i].connected) continue;
+                    clients[i] = Client();
+                    clients[i].connected = true;
+                    clients[i].addr = from;
+                    slot = i;
+                    if (verbose) std::printf("Player joined as car %d\n", slot + 1);
+                }
+            }
+            std::uint8_t reply[2] = { Welcome, static_cast<std::uint8_t>(slot + 1) };
+            socket.sendTo(from, reply, sizeof(reply), nowUs);
+        }
+        if (slot < 0) continue;
+
+        Client& c = clients[slot];
+        c.lastHeardUs = nowUs;
+        if (type != InputPacket) continue;
+
+        const std::uint32_t acked = r.u32();
+        const int count = r.u8();
+        for (int i = 0; i < count && r.ok; i++) {
+            const std::uint32_t seq = r.u32();
+            const float dt = r.u16() / 10000.0f;
+            const float impulse = static_cast<std::int16_t>(r.u16()) / 64.0f;
+            if (!r.ok || seq <= c.lastInput) continue;
+            netStepCar(state.cars[slot + 1], impulse, dt, state.started);
+            c.lastInput = seq;
+        }
+        if (r.ok && acked > c.ackedTick && acked <= tick) c.ackedTick = acked;
+    }
+
+    for (int i = 0; i < NET_CARS - 1; i++) {
+        Client& c = clients[i];
+        if (c.connected && c.lastHeardUs && nowUs - c.lastHeardUs > CLIENT_TIMEOUT_US) {
+            c.connected = false;
+            if (verbose) std::printf("Player on car %d timed out\n", i + 1);
+        }
+    }
+}
+
+void NetServer::update(NetRaceState& state, std::int64_t nowUs) {
+    if (nowUs < nextTickUs) return;
+    nextTickUs = nowUs - nextTickUs > tickUs ? nowUs + tickUs : nextTickUs + tickUs;
+
+    state.tick = ++tick;
+    const NetQuantized q = netQuantize(state);
+    history[tick % HISTORY] = q;
+    for (int i = 0; i < NET_CARS - 1; i++) {
+        if (clients[i].connected) sendSnapshot(i, q, nowUs);
+    }
+}
+
+void NetServer::sendSnapshot(int slot, const NetQuantized& q, std::int64_t nowUs) {
+    const Client& c = clients[slot];
+    NetQuantized base = {};
+    std::uint32_t baseTick = 0;
+    if (c.ackedTick && tick - c.ackedTick < HISTORY && history[c.ackedTick % HISTORY].tick == c.ackedTick) {
+        base = history[c.ackedTick % HISTORY];
+        baseTick = c.ackedTick;
+    }
+
+    std::uint8_t buf[NetSocket::MAX_PACKET];
+    Writer w{ buf, 0 };
+    w.u8(Snapshot);
+    w.u32(q.tick);
+    w.u32(baseTick);
+    w.u32(c.lastInput);
+    writeDelta(w, base, q);
+    socket.sendTo(c.addr, buf, w.len, nowUs);
+
+    snapshotBytes += w.len;
+    if (baseTick) deltaSnapshots++;
+    else fullSnapshots++;
+}
+
+bool NetClient::connect(const char* hostPort, std::int64_t nowUs) {
+    if (!netResolve(hostPort, server) || !socket.open(0)) return false;
+    slot = -1;
+    lastHelloUs = nowUs - HELLO_INTERVAL_US;
+    return true;
+}
+
+void NetClient::close() {
+    socket.close();
+    slot = -1;
+}
+
+NetCar NetClient::predict() const {
+    NetCar car = latest.cars[std::max(0, slot)];
+    std::uint32_t first = lastProcessed + 1;
+    if (nextInput - first > INPUTS) first = nextInput - INPUTS;
+    for (std::uint32_t seq = first; seq < nextInput; seq++) {
+        const Input& in = inputs[seq % INPUTS];
+        netStepCar(car, in.impulse / 64.0f, in.dtTenthMs / 10000.0f, latest.started);
+    }
+    return car;
+}
+
+void NetClient::sendInput(float impulse, float dt, std::int64_t nowUs) {
+    socket.flush(nowUs);
+    if (!joined()) {
+        if (!rejected() && nowUs - lastHelloUs >= HELLO_INTERVAL_US) {
+            const std::uint8_t hello = Hello;
+            socket.sendTo(server, &hello, 1, nowUs);
+            lastHelloUs = nowUs;
+        }
+        return;
+    }
+
+    Input& in = inputs[nextInput % INPUTS];
+    in.seq = nextInput++;
+    in.dtTenthMs = static_cast<std::uint16_t>(std::min(65535.0f, std::round(dt * 10000.0f)));
+    in.impulse = quantizeImpulse(impulse);
+
+    std::uint8_t buf[NetSocket::MAX_PACKET];
+    Writer w{ buf, 0 };
+    w.u8(InputPacket);
+    w.u32(newestTick);
+    const std::uint32_t unacked = nextInput - 1 - lastProcessed;
+    const int count = static_cast<int>(std::min<std::uint32_t>(unacked, INPUT_REDUNDANCY));
+    w.u8(static_cast<std::uint8_t>(count));
+    for (std::uint32_t seq = nextInput - count; seq < nextInput; seq++) {
+        const Input& s = inputs[seq % INPUTS];
+        w.u32(s.seq);
+        w.u16(s.dtTenthMs);
+        w.u16(static_cast<std::uint16_t>(s.impulse));
+    }
+    socket.sendTo(server, buf, w.len, nowUs);
+}
+
+void NetClient::poll(std::int64_t nowUs) {
+    socket.flush(nowUs);
+
+    std::uint8_t buf[NetSocket::MAX_PACKET];
+    sockaddr_in from;
+    int len;
+    while ((len = socket.receive(from, buf, sizeof(buf))) > 0) {
+        if (!sameAddr(from, server)) continue;
+        Reader r{ buf, len };
+        const std::uint8_t type = r.u8();
+
+        if (type == Welcome) {
+            const int assigned = r.u8();
+            if (r.ok && slot < 0) {
+                slot = assigned;
+                if (verbose && slot > 0) std::printf("Joined the race as car %d\n", slot);
+                if (verbose && slot == 0) std::printf("Server is full\n");
+            }
+            continue;
+        }
+        if (type != Snapshot || !joined()) continue;
+
+        const std::uint32_t tick = r.u32();
+        const std::uint32_t baseTick = r.u32();
+        const std::uint32_t processed = r.u32();
+        if (!r.ok || tick <= newestTick) continue;
+
+        NetQuantized base = {};
+        if (baseTick) {
+            if (history[baseTick % HISTORY].tick != baseTick) {
+                undecodable++;
+                continue;
+            }
+            base = history[baseTick % HISTORY];
+        }
+        NetQuantized q = readDelta(r, base);
+        if (!r.ok) continue;
+        q.tick = tick;
+
+        const NetCar before = predict();
+        history[tick % HISTORY] = q;
+        newestTick = tick;
+        latest = netDequantize(q);
+        lastProcessed = std::max(lastProcessed, processed);
+        const NetCar after = predict();
+        const float correction = std::abs(after.pos - before.pos);
+        correctionSum += correction;
+        correctionMax = std::max(correctionMax, correction);
+        snapshots++;
+
+        if (bufferedCount == BUFFERED) {
+            std::memmove(buffered, buffered + 1, sizeof(Buffered) * (BUFFERED - 1));
+            bufferedCount--;
+        }
+        buffered[bufferedCount++] = { nowUs, latest };
+    }
+}
+
+NetRaceState NetClient::view(std::int64_t nowUs) const {
+    NetRaceState s = latest;
+    const std::int64_t t = nowUs - interpDelayUs;
+
+    if (bufferedCount > 0) {
+        int b = 0;
+        while (b < bufferedCount && buffered[b].receivedUs < t) b++;
+        const Buffered& hi = buffered[std::min(b, bufferedCount - 1)];
+        const Buffered& lo = buffered[std::max(b - 1, 0)];
+        float f = 0.0f;
+        if (hi.receivedUs > lo.receivedUs) {
+            f = std::max(0.0f, std::min(1.0f,
+                static_cast<float>(t - lo.receivedUs) / static_cast<float>(hi.receivedUs - lo.receivedUs)));
+        }
+        for (int i = 0; i < NET_CARS; i++) {
+            s.cars[i].pos = lo.state.cars[i].pos + (hi.state.cars[i].pos - lo.state.cars[i].pos) * f;
+            s.cars[i].speed = lo.state.cars[i].speed + (hi.state.cars[i].speed - lo.state.cars[i].speed) * f;
+        }
+    }
+
+    if (slot > 0) s.cars[slot] = predict();
+    return s;
+}
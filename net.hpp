@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <netinet/in.h>
+
+// Authoritative UDP multiplayer. The host runs the race and owns car 0;
+// up to two clients drive cars 1 and 2. Clients send their inputs with the
+// id of the newest snapshot they received; the server replies with
+// quantized snapshots delta-encoded against that acknowledged snapshot.
+// Clients predict their own car by replaying unacknowledged inputs on top
+// of the last server state and interpolate the other cars.
+
+static const int NET_CARS = 3;
+static const std::uint16_t NET_DEFAULT_PORT = 5000;
+static const float NET_FINISH_LINE = 800.0f;
+
+struct NetCar {
+    float pos;
+    float speed;
+    int finishPlace;
+};
+
+struct NetRaceState {
+    std::uint32_t tick;
+    bool started;
+    NetCar cars[NET_CARS];
+};
+
+// One input step of a remotely driven car. Friction is expressed per 1/60 s
+// so the result does not depend on the client's frame rate.
+void netStepCar(NetCar& car, float impulse, float dt, bool started);
+
+struct NetLinkStats {
+    std::uint64_t bytesSent = 0;
+    std::uint64_t bytesReceived = 0;
+    std::uint64_t packetsSent = 0;
+    std::uint64_t packetsReceived = 0;
+    std::uint64_t packetsLost = 0;
+};
+
+// Non-blocking UDP socket with an optional link conditioner that drops
+// outgoing packets at random and holds the rest back by a fixed latency.
+class NetSocket {
+public:
+    static const int MAX_PACKET = 256;
+    static const int MAX_DELAYED = 512;
+
+    bool open(std::uint16_t port);
+    void close();
+    void sendTo(const sockaddr_in& to, const std::uint8_t* data, int len, std::int64_t nowUs);
+    int receive(sockaddr_in& from, std::uint8_t* buf, int cap);
+    void flush(std::int64_t nowUs);
+
+    float lossPercent = 0.0f;
+    int latencyMs = 0;
+    NetLinkStats stats;
+
+private:
+    struct Delayed {
+        std::int64_t dueUs;
+        sockaddr_in to;
+        int len;
+        std::uint8_t data[MAX_PACKET];
+    };
+
+    void transmit(const sockaddr_in& to, const std::uint8_t* data, int len);
+
+    int fd = -1;
+    std::uint32_t rng = 0x9e3779b9u;
+    Delayed delayed[MAX_DELAYED];
+    int delayedHead = 0;
+    int delayedCount = 0;
+};
+
+bool netResolve(const char* hostPort, sockaddr_in& out);
+
+struct NetQuantized {
+    std::uint32_t tick;
+    std::uint8_t started;
+    std::uint16_t pos[NET_CARS];
+    std::int16_t speed[NET_CARS];
+    std::uint8_t place[NET_CARS];
+};
+
+NetQuantized netQuantize(const NetRaceState& s);
+NetRaceState netDequantize(const NetQuantized& q);
+
+class NetServer {
+public:
+    static const int HISTORY = 64;
+
+    bool open(std::uint16_t port, int tickRate);
+    void close();
+
+    // Applies every input received since the last call to the remote cars
+    // in `state`, then drops clients that have gone quiet.
+    void poll(NetRaceState& state, std::int64_t nowUs);
+
+    // Sends a snapshot to each client when the next tick is due.
+    void update(NetRaceState& state, std::int64_t nowUs);
+
+    bool remote(int car) const { return car > 0 && clients[car - 1].connected; }
+
+    NetSocket socket;
+    bool verbose = true;
+    std::uint64_t fullSnapshots = 0;
+    std::uint64_t deltaSnapshots = 0;
+    std::uint64_t snapshotBytes = 0;
+
+private:
+    struct Client {
+        bool connected = false;
+        sockaddr_in addr{};
+        std::int64_t lastHeardUs = 0;
+        std::uint32_t ackedTick = 0;
+        std::uint32_t lastInput = 0;
+    };
+
+    void sendSnapshot(int slot, const NetQuantized& q, std::int64_t nowUs);
+
+    Client clients[NET_CARS - 1];
+    NetQuantized history[HISTORY] = {};
+    std::uint32_t tick = 0;
+    std::int64_t tickUs = 0;
+    std::int64_t nextTickUs = 0;
+};
+
+class NetClient {
+public:
+    static const int INPUTS = 128;
+    static const int HISTORY = 64;
+    static const int BUFFERED = 32;
+
+    bool connect(const char* hostPort, std::int64_t nowUs);
+    void close();
+
+    // Records this frame's input, predicts the local car and sends the
+    // unacknowledged inputs to the server.
+    void sendInput(float impulse, float dt, std::int64_t nowUs);
+
+    void poll(std::int64_t nowUs);
+
+    // Own car predicted, other cars interpolated `interpDelayUs` behind.
+    NetRaceState view(std::int64_t nowUs) const;
+
+    bool joined() const { return slot > 0; }
+    // The server answered with slot 0 (full); hellos are no longer sent.
+    bool rejected() const { return slot == 0; }
+
+    int slot = -1;
+    std::int64_t interpDelayUs = 100000;
+    NetSocket socket;
+    bool verbose = true;
+    std::uint64_t snapshots = 0;
+    std::uint64_t undecodable = 0;
+    double correctionSum = 0.0;
+    float correctionMax = 0.0f;
+
+private:
+    struct Input {
+        std::uint32_t seq;
+        std::uint16_t dtTenthMs;
+        std::int16_t impulse;
+    };
+
+    struct Buffered {
+        std::int64_t receivedUs;
+        NetRaceState state;
+    };
+
+    NetCar predict() const;
+
+    sockaddr_in server{};
+    std::int64_t lastHelloUs = 0;
+    std::uint32_t nextInput = 1;
+    std::uint32_t lastProcessed = 0;
+    Input inputs[INPUTS] = {};
+    NetQuantized history[HISTORY] = {};
+    std::uint32_t newestTick = 0;
+    NetRaceState latest{};
+    Buffered buffered[BUFFERED] = {};
+    int bufferedCount = 0;
+};
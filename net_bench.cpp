@@ -0,0 +1,130 @@
+#include "net.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Runs a server and two bot clients over loopback on a virtual 60 Hz clock
+// for each combination of tick rate, packet loss and latency, and reports
+// per-client bandwidth, snapshot size, prediction error and server cost.
+
+namespace {
+    struct Scenario {
+        int tickRate;
+        float lossPercent;
+        int latencyMs;
+    };
+
+    const int CLIENTS = 2;
+    const float SECONDS = 20.0f;
+    const std::int64_t FRAME_US = 16667;
+
+    void run(const Scenario& sc, std::uint16_t port) {
+        NetServer server;
+        server.verbose = false;
+        if (!server.open(port, sc.tickRate)) {
+            std::printf("cannot bind port %u\n", port);
+            return;
+        }
+
+        char addr[32];
+        std::snprintf(addr, sizeof(addr), "127.0.0.1:%u", port);
+        NetClient clients[CLIENTS];
+        for (NetClient& c : clients) {
+            c.verbose = false;
+            c.connect(addr, 0);
+            c.socket.lossPercent = sc.lossPercent;
+            c.socket.latencyMs = sc.latencyMs / 2;
+        }
+        server.socket.lossPercent = sc.lossPercent;
+        server.socket.latencyMs = sc.latencyMs / 2;
+
+        NetRaceState state = {};
+        state.started = true;
+        state.cars[0].speed = 40.0f;
+
+        std::srand(1234);
+        const int frames = static_cast<int>(SECONDS * 1000000 / FRAME_US);
+        std::int64_t serverNs = 0;
+        std::int64_t serverTicks = 0;
+        std::uint64_t downStart[CLIENTS] = {}, upStart[CLIENTS] = {};
+        const int warmup = 60;
+
+        for (int f = 0; f < frames; f++) {
+            const std::int64_t now = f * FRAME_US;
+            if (f == warmup) {
+                for (int i = 0; i < CLIENTS; i++) {
+                    upStart[i] = clients[i].socket.stats.bytesSent;
+                    downStart[i] = clients[i].socket.stats.bytesReceived;
+                }
+            }
+
+            for (NetClient& c : clients) {
+                float impulse = 0.0f;
+                const int r = std::rand() % 100;
+                if (r < 30) impulse = 2.5f;
+                else if (r < 32) impulse = 20.0f;
+                else if (r < 36) impulse = -2.0f;
+                c.sendInput(impulse, FRAME_US / 1e6f, now);
+            }
+
+            const auto t0 = std::chrono::steady_clock::now();
+            server.poll(state, now);
+            state.cars[0].pos += state.cars[0].speed * (FRAME_US / 1e6f);
+            if (state.cars[0].pos > NET_FINISH_LINE) state.cars[0].pos = -45.0f;
+            for (int i = 1; i < NET_CARS; i++) {
+                if (state.cars[i].pos >= NET_FINISH_LINE) state.cars[i].pos = -45.0f;
+            }
+            const std::uint32_t before = state.tick;
+            server.update(state, now);
+            serverNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+            if (state.tick != before) serverTicks++;
+
+            for (NetClient& c : clients) c.poll(now);
+        }
+
+        const float measured = (frames - warmup) * FRAME_US / 1e6f;
+        double down = 0.0, up = 0.0, correction = 0.0;
+        std::uint64_t snapshots = 0;
+        for (int i = 0; i < CLIENTS; i++) {
+            down += (clients[i].socket.stats.bytesReceived - downStart[i]) / measured;
+            up += (clients[i].socket.stats.bytesSent - upStart[i]) / measured;
+            correction += clients[i].snapshots ? clients[i].correctionSum / clients[i].snapshots : 0.0;
+            snapshots += clients[i].snapshots;
+        }
+        const std::uint64_t sent = server.fullSnapshots + server.deltaSnapshots;
+
+        std::printf("%4d Hz %5.1f%% %4d ms | down %7.0f B/s up %7.0f B/s | snap %5.1f B, %4.1f%% full | "
+                    "recv %6llu | corr %.3f | server %.2f us/tick\n",
+            sc.tickRate, sc.lossPercent, sc.latencyMs,
+            down / CLIENTS, up / CLIENTS,
+            sent ? static_cast<double>(server.snapshotBytes) / sent : 0.0,
+            sent ? 100.0 * server.fullSnapshots / sent : 0.0,
+            (unsigned long long)snapshots, correction / CLIENTS,
+            serverTicks ? serverNs / 1000.0 / serverTicks : 0.0);
+
+        for (NetClient& c : clients) c.close();
+        server.close();
+    }
+}
+
+int main(int argc, char** argv) {
+    std::uint16_t port = argc > 1 ? static_cast<std::uint16_t>(std::atoi(argv[1])) : 0;
+    if (!port) port = 47000;
+
+    const int tickRates[] = { 20, 30, 60 };
+    const float losses[] = { 0.0f, 5.0f, 20.0f };
+    const int latencies[] = { 0, 60, 150 };
+
+    std::printf("tick   loss    rtt | per-client bandwidth          | snapshots             | "
+                "received | avg prediction correction | server cost\n");
+    for (int rate : tickRates) {
+        for (float loss : losses) {
+            for (int latency : latencies) {
+                run({ rate, loss, latency }, port++);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "particle_sort.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static_assert(sizeof(ParticleDraw) == 5 * sizeof(float), "the SIMD key loop strides ParticleDraw as 5 floats");
+
+const std::uint32_t* DepthSorter::sort(const ParticleDraw* draws, int count, const vecmath::Mat4& view, float farZ) {
+    keys.resize(count);
+    order.resize(count);
+    std::memset(histogram, 0, sizeof(histogram));
+
+    // Distance along the view direction, scaled to the key range; farther
+    // particles get smaller keys so ascending key order is back to front.
+    // Neighbouring particles share keys, so a single histogram stalls on
+    // back-to-back increments of the same counter: each lane counts into
+    // its own copy.
+    const float* m = view.m;
+    const float maxKey = static_cast<float>(BUCKETS - 1);
+    const float scale = maxKey / farZ;
+    const float ax = -m[2] * scale, ay = -m[6] * scale, az = -m[10] * scale, aw = -m[14] * scale;
+    int i = 0;
+#if VECMATH_SSE || VECMATH_NEON
+    {
+        using namespace vecmath::detail;
+        const f4 vx = splat(ax), vy = splat(ay), vz = splat(az), vw = splat(aw);
+        const f4 zero = splat(0.0f), top = splat(maxKey);
+        std::int32_t k[LANES];
+        for (; i + LANES <= count; i += LANES) {
+            const float* p = &draws[i].x;
+            const f4 x = set(p[0], p[5], p[10], p[15]);
+            const f4 y = set(p[1], p[6], p[11], p[16]);
+            const f4 z = set(p[2], p[7], p[12], p[17]);
+            const f4 q = min(top, max(zero, madd(vx, x, madd(vy, y, madd(vz, z, vw)))));
+            storeInt(k, madd(q, splat(-1.0f), top));
+            for (int l = 0; l < LANES; l++) {
+                keys[i + l] = static_cast<std::uint16_t>(k[l]);
+                histogram[l][k[l]]++;
+            }
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        const ParticleDraw& p = draws[i];
+        const float q = std::min(maxKey, std::max(0.0f, ax * p.x + ay * p.y + az * p.z + aw));
+        keys[i] = static_cast<std::uint16_t>(maxKey - q);
+        histogram[0][keys[i]]++;
+    }
+
+    std::uint32_t sum = 0;
+    for (int d = 0; d < BUCKETS; d++) {
+        const std::uint32_t n = histogram[0][d] + histogram[1][d] + histogram[2][d] + histogram[3][d];
+        histogram[0][d] = sum;
+        sum += n;
+    }
+
+    for (int j = 0; j < count; j++) order[histogram[0][keys[j]]++] = static_cast<std::uint32_t>(j);
+    return order.data();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "vecmath.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Per-frame snapshot of one particle as the renderer needs it.
+struct ParticleDraw {
+    float x, y, z;
+    float size;
+    float alpha;
+};
+
+// Orders particles back to front by view depth, quantized to 11-bit keys
+// (about 15 cm steps at the game's 300 m far plane), with one counting-sort
+// pass; particles inside one step keep their input order. Keys are computed
+// four at a time on the vecmath SIMD path. Buffers are kept between frames
+// so steady-state sorting does not allocate.
+class DepthSorter {
+public:
+    static constexpr int KEY_BITS = 11;
+
+    const std::uint32_t* sort(const ParticleDraw* draws, int count, const vecmath::Mat4& view, float farZ);
+
+private:
+    static constexpr int BUCKETS = 1 << KEY_BITS;
+    static constexpr int LANES = 4;
+
+    std::vector<std::uint16_t> keys;
+    std::vector<std::uint32_t> order;
+    std::uint32_t histogram[LANES][BUCKETS];
+};
@@ -0,0 +1,143 @@
+#include "particle_sort.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Sorts a drifting dust cloud back to front from a camera that follows it
+// down the track, comparing std::sort on float depth with DepthSorter.
+// Particles die and respawn as in the game, and every frame's order is
+// checked against the quantized depth. Up to 100k particles the average
+// sort must stay within a 1 ms budget; the process exits non-zero otherwise.
+
+using namespace vecmath;
+
+namespace {
+    const float FAR_Z = 300.0f;
+    const double BUDGET_MS = 1.0;
+    const int BUDGET_COUNT = 100000;
+
+    struct Particle {
+        float x, y, z;
+        float vx, vy, vz;
+        float life;
+    };
+
+    float frand(float lo, float hi) {
+        return lo + (hi - lo) * (std::rand() / static_cast<float>(RAND_MAX));
+    }
+
+    Particle spawn(float camZ) {
+        return { frand(-20, 20), frand(0, 3), camZ + frand(0, 250),
+                 frand(-1, 1), frand(0, 2), frand(-10, 0), frand(0.5f, 3.0f) };
+    }
+
+    struct Scene {
+        std::vector<Particle> particles;
+        std::vector<ParticleDraw> draws;
+        float camZ = 0.0f;
+        std::size_t target = 0;
+
+        void step(float dt) {
+            camZ += 40.0f * dt;
+            std::size_t out = 0;
+            for (Particle p : particles) {
+                p.x += p.vx * dt;
+                p.y += p.vy * dt;
+                p.z += p.vz * dt;
+                p.life -= dt;
+                if (p.life > 0.0f) particles[out++] = p;
+            }
+            particles.resize(out);
+            while (particles.size() < target) particles.push_back(spawn(camZ));
+
+            draws.resize(particles.size());
+            for (std::size_t i = 0; i < particles.size(); i++) {
+                const Particle& p = particles[i];
+                draws[i] = { p.x, p.y, p.z, 0.1f, 0.5f };
+            }
+        }
+
+        Mat4 view() const {
+            return Mat4::lookAt({ -1.0f, 2.0f, camZ - 3.0f }, { -1.0f, 0.6f, camZ }, { 0, 1, 0 });
+        }
+    };
+
+    bool backToFront(const ParticleDraw* draws, const std::uint32_t* order, int n, const Mat4& view) {
+        const float* m = view.m;
+        float prev = 1e30f;
+        for (int i = 0; i < n; i++) {
+            const ParticleDraw& p = draws[order[i]];
+            const float depth = -(m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]);
+            const float q = std::min(1.0f, std::max(0.0f, depth / FAR_Z));
+            if (q > prev + 1.0f / ((1 << DepthSorter::KEY_BITS) - 1)) return false;
+            prev = q;
+        }
+        return true;
+    }
+
+    bool run(int count) {
+        const int frames = 240;
+        const int warmup = 10;
+        Scene scene;
+        scene.target = count;
+        scene.particles.reserve(count);
+        scene.step(0.0f);
+
+        DepthSorter sorter;
+        std::vector<std::uint32_t> stdOrder;
+        std::vector<float> depth;
+
+        double stdMs = 0.0, radixMs = 0.0, worstMs = 0.0;
+        bool ok = true;
+        for (int f = 0; f < frames; f++) {
+            scene.step(1.0f / 60.0f);
+            const Mat4 view = scene.view();
+            const int n = static_cast<int>(scene.draws.size());
+            const ParticleDraw* draws = scene.draws.data();
+
+            const auto t0 = std::chrono::steady_clock::now();
+            const std::uint32_t* order = sorter.sort(draws, n, view, FAR_Z);
+            const auto t1 = std::chrono::steady_clock::now();
+
+            const float* m = view.m;
+            stdOrder.resize(n);
+            depth.resize(n);
+            for (int i = 0; i < n; i++) {
+                const ParticleDraw& p = draws[i];
+                depth[i] = -(m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]);
+                stdOrder[i] = static_cast<std::uint32_t>(i);
+            }
+            std::sort(stdOrder.begin(), stdOrder.end(),
+                [&](std::uint32_t a, std::uint32_t b) { return depth[a] > depth[b]; });
+            const auto t2 = std::chrono::steady_clock::now();
+
+            if (f >= warmup) {
+                const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+                radixMs += ms;
+                worstMs = std::max(worstMs, ms);
+                stdMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+            }
+            ok = ok && backToFront(draws, order, n, view);
+        }
+
+        const int measured = frames - warmup;
+        const bool budgeted = count <= BUDGET_COUNT;
+        const bool inBudget = radixMs / measured <= BUDGET_MS;
+        std::printf("%8d particles | std::sort %8.3f ms | radix %7.3f ms (worst %7.3f) | x%5.1f | %s | %s\n",
+            count, stdMs / measured, radixMs / measured, worstMs,
+            radixMs > 0.0 ? stdMs / radixMs : 0.0, ok ? "order ok" : "ORDER WRONG",
+            !budgeted ? "no budget" : inBudget ? "1 ms budget pass" : "1 ms budget FAIL");
+        return ok && (!budgeted || inBudget);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::srand(7);
+    if (argc > 1) return run(std::atoi(argv[1])) ? 0 : 1;
+    bool pass = true;
+    for (int count : { 200, 1000, 10000, 100000, 1000000 }) pass = run(count) && pass;
+    return pass ? 0 : 1;
+}
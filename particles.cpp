@@ -0,0 +1,67 @@
+#include "particles.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+std::vector<Particle> particles;
+std::size_t particleCap = MAX_PARTICLES;
+
+void initParticles() {
+    particles.reserve(particleCap + DUST_PER_SPAWN);
+}
+
+void setParticleCap(std::size_t cap) {
+    particleCap = cap;
+    particles.reserve(cap + DUST_PER_SPAWN);
+    if (particles.size() > cap) particles.erase(particles.begin(), particles.begin() + (particles.size() - cap));
+}
+
+void updateParticles(float dt) {
+    particles.erase(
+        std::remove_if(particles.begin(), particles.end(),
+            [](const Particle& p) { return p.life <= 0.0f; }),
+        particles.end()
+    );
+    
+    for (auto& p : particles) {
+        p.x += p.vx * dt;
+        p.y += p.vy * dt;
+        p.z += p.vz * dt;
+        p.life -= dt;
+        p.vy -= 0.5f * dt;
+    }
+}
+
+ParticleDraw* prepareParticleDraws(FrameArena& arena, int& count) {
+    ParticleDraw* draws = arena.alloc<ParticleDraw>(particles.size());
+    count = draws ? static_cast<int>(particles.size()) : 0;
+    for (int i = 0; i < count; i++) {
+        const Particle& p = particles[i];
+        draws[i] = { p.x, p.y, p.z, p.size, p.life / 1.0f * 0.6f };
+    }
+    return draws;
+}
+
+void spawnDustParticles(float carX, float carZ, float speed, float groundY) {
+    if (std::abs(speed) < 0.1f) return;
+    for (std::size_t i = 0; i < DUST_PER_SPAWN; i++) {
+        Particle p;
+        p.x = carX + ((rand() % 100) / 100.0f - 0.5f) * 0.5f;
+        p.y = groundY + 0.1f;
+        p.z = carZ - 0.5f + ((rand() % 100) / 100.0f - 0.5f) * 0.3f;
+        
+        p.vx = ((rand() % 100) / 100.0f - 0.5f) * 1.0f;
+        p.vy = (rand() % 100) / 100.0f * 2.0f;
+        p.vz = -std::abs(speed) * 0.3f + ((rand() % 100) / 100.0f - 0.5f) * 0.5f;
+        
+        p.life = 0.5f + (rand() % 100) / 100.0f * 0.5f;
+        p.size = 0.05f + (rand() % 100) / 100.0f * 0.1f;
+        
+        particles.push_back(p);
+    }
+
+    if (particles.size() > particleCap) {
+        particles.erase(particles.begin(), particles.begin() + (particles.size() - particleCap));
+    }
+}
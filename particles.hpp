@@ -0,0 +1,29 @@
+#pragma once
+
+#include "frame_arena.hpp"
+#include "particle_sort.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// Dust kicked up behind the cars. Simulation only; drawing is in render.cpp.
+
+struct Particle {
+    float x, y, z;
+    float vx, vy, vz;
+    float life;
+    float size;
+};
+
+const std::size_t MAX_PARTICLES = 200;
+const std::size_t DUST_PER_SPAWN = 5;
+
+extern std::vector<Particle> particles;
+extern std::size_t particleCap;
+
+void initParticles();
+// Limits live dust to `cap` (MAX_PARTICLES by default), dropping the oldest.
+void setParticleCap(std::size_t cap);
+void updateParticles(float dt);
+ParticleDraw* prepareParticleDraws(FrameArena& arena, int& count);
+void spawnDustParticles(float carX, float carZ, float speed, float groundY);
@@ -1,11 +1,24 @@
 #version 120
+// Car parts are pseudo-instanced: the modelview matrix holds only the camera
+// and each part's model matrix arrives as its top three rows in generic
+// attributes, constant across the shared mesh it is drawn with.
+attribute vec4 modelRow0;
+attribute vec4 modelRow1;
+attribute vec4 modelRow2;
+
 varying vec3 normal;
 varying vec3 position;
 
 void main()
 {
-    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
-    normal = normalize(gl_NormalMatrix * gl_Normal);
-    position = vec3(gl_ModelViewMatrix * gl_Vertex);
+    vec4 world = vec4(dot(modelRow0, gl_Vertex), dot(modelRow1, gl_Vertex), dot(modelRow2, gl_Vertex), 1.0);
+    // Mesh normals are axis-aligned or radial in a uniformly scaled plane,
+    // so the scaled normal only needs renormalising.
+    vec3 n = vec3(dot(modelRow0.xyz, gl_Normal), dot(modelRow1.xyz, gl_Normal), dot(modelRow2.xyz, gl_Normal));
+
+    gl_Position = gl_ModelViewProjectionMatrix * world;
+    normal = normalize(gl_NormalMatrix * n);
+    position = vec3(gl_ModelViewMatrix * world);
+    gl_FrontColor = gl_Color;
     gl_TexCoord[0] = gl_MultiTexCoord0;
 }
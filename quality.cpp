@@ -0,0 +1,114 @@
+#include "quality.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+const QualityPreset qualityPresets[QUALITY_PRESETS] = {
+    { "low",     6,  60, 150.0f, 4.0f,  800,  600, TextureFilter::Nearest },
+    { "medium", 10, 120, 220.0f, 3.0f, 1024,  768, TextureFilter::Linear },
+    { "high",   16, 200, 300.0f, 2.0f, 1024,  768, TextureFilter::Linear },
+    { "ultra",  24, 400, 450.0f, 1.5f, 1280,  960, TextureFilter::Trilinear },
+};
+
+int qualityPresetByName(const char* name) {
+    for (int i = 0; i < QUALITY_PRESETS; i++) {
+        if (std::strcmp(qualityPresets[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+namespace {
+    std::string trim(const std::string& s) {
+        const std::size_t b = s.find_first_not_of(" \t\r");
+        if (b == std::string::npos) return "";
+        const std::size_t e = s.find_last_not_of(" \t\r");
+        return s.substr(b, e - b + 1);
+    }
+}
+
+// One "key = value" per line; unknown keys are ignored so the file can be
+// edited by hand.
+bool loadQualityConfig(const char* path, QualityConfig& config) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    QualityConfig c;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        const std::size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        const std::string key = trim(line.substr(0, eq));
+        const std::string value = trim(line.substr(eq + 1));
+
+        if (key == "preset") {
+            const int p = qualityPresetByName(value.c_str());
+            if (p >= 0) c.preset = p;
+        }
+        else if (key == "target_fps") {
+            const float fps = static_cast<float>(std::atof(value.c_str()));
+            if (fps > 0.0f) c.targetFps = fps;
+        }
+        else if (key == "calibrated") c.calibrated = value == "1";
+        else if (key == "renderer") c.renderer = value;
+        else if (key.compare(0, 3, "ms.") == 0) {
+            const int p = qualityPresetByName(key.c_str() + 3);
+            if (p >= 0 && std::sscanf(value.c_str(), "%f %f", &c.meanMs[p], &c.p95Ms[p]) != 2) {
+                c.meanMs[p] = c.p95Ms[p] = 0.0f;
+            }
+        }
+    }
+    config = c;
+    return true;
+}
+
+bool saveQualityConfig(const char* path, const QualityConfig& config) {
+    std::FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    std::fprintf(f, "# CarRace quality settings. Delete this file (or run with --recalibrate)\n");
+    std::fprintf(f, "# to measure again; presets: low, medium, high, ultra.\n");
+    std::fprintf(f, "preset = %s\n", qualityPresets[config.preset].name);
+    std::fprintf(f, "target_fps = %g\n", config.targetFps);
+    std::fprintf(f, "calibrated = %d\n", config.calibrated ? 1 : 0);
+    if (!config.renderer.empty()) std::fprintf(f, "renderer = %s\n", config.renderer.c_str());
+    std::fprintf(f, "# frame time per preset: mean and 95th percentile, ms\n");
+    for (int i = 0; i < QUALITY_PRESETS; i++) {
+        if (config.p95Ms[i] > 0.0f) {
+            std::fprintf(f, "ms.%s = %.3f %.3f\n", qualityPresets[i].name, config.meanMs[i], config.p95Ms[i]);
+        }
+    }
+    return std::fclose(f) == 0;
+}
+
+void summarizeFrameTimes(const float* ms, int count, float& mean, float& p95) {
+    mean = p95 = 0.0f;
+    if (count <= 0) return;
+    std::vector<float> sorted(ms, ms + count);
+    double sum = 0.0;
+    for (float t : sorted) sum += t;
+    mean = static_cast<float>(sum / count);
+    const int k = std::min(count - 1, static_cast<int>(count * 0.95f));
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    p95 = sorted[k];
+}
+
+void clearQualityMeasurements(QualityConfig& config) {
+    for (int i = 0; i < QUALITY_PRESETS; i++) config.meanMs[i] = config.p95Ms[i] = 0.0f;
+    config.calibrated = false;
+}
+
+int pickQualityPreset(const QualityConfig& config) {
+    const float budgetMs = 1000.0f / config.targetFps;
+    int best = 0;
+    for (int i = 0; i < QUALITY_PRESETS; i++) {
+        if (config.p95Ms[i] <= 0.0f) continue;
+        if (config.p95Ms[i] > budgetMs) break;
+        best = i;
+    }
+    return best;
+}
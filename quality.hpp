@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Quality presets and the saved result of the first-launch calibration.
+// Presets are ordered from cheapest to most expensive; "high" matches the
+// settings the game used before presets existed. Nothing here touches GL.
+
+enum class TextureFilter { Nearest, Linear, Trilinear };
+
+struct QualityPreset {
+    const char* name;
+    int slices;                // GLU tessellation of cacti and poles; wheels and dust scale with it
+    std::size_t particleCap;
+    float drawDistance;        // far plane and scene cull distance, metres
+    float terrainPixelError;   // allowed screen-space error of the terrain LOD
+    unsigned windowWidth, windowHeight;
+    TextureFilter textureFilter;
+};
+
+const int QUALITY_PRESETS = 4;
+const int QUALITY_DEFAULT = 2;
+extern const QualityPreset qualityPresets[QUALITY_PRESETS];
+
+// Index of the preset called `name`, or -1.
+int qualityPresetByName(const char* name);
+
+struct QualityConfig {
+    int preset = QUALITY_DEFAULT;
+    float targetFps = 60.0f;
+    bool calibrated = false;
+    std::string renderer;                  // GL_RENDERER the measurements were taken with
+    float meanMs[QUALITY_PRESETS] = {};    // 0 when the preset was not measured
+    float p95Ms[QUALITY_PRESETS] = {};
+};
+
+bool loadQualityConfig(const char* path, QualityConfig& config);
+bool saveQualityConfig(const char* path, const QualityConfig& config);
+
+// Mean and 95th percentile of a run of frame times.
+void summarizeFrameTimes(const float* ms, int count, float& mean, float& p95);
+
+// Forgets every per-preset timing and the calibrated flag, so a new
+// calibration never mixes in numbers from an earlier run or another GPU.
+void clearQualityMeasurements(QualityConfig& config);
+
+// Highest measured preset whose 95th percentile frame time fits the target
+// frame rate; the lowest preset when none does. Presets above the first
+// measured one that misses are never picked: they only cost more.
+int pickQualityPreset(const QualityConfig& config);
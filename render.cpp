@@ -0,0 +1,867 @@
+#include "render.hpp"
+#include "game.hpp"
+#include "particles.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+FrameArena frameArena(256 * 1024);
+
+TerrainPatchStats terrainPatchStats;
+
+namespace {
+    float terrainPixelError = 2.0f;
+
+    // GLU slices at "high"; every shape keeps its ratio to this.
+    const int BASE_SLICES = 16;
+    int tessellation = BASE_SLICES;
+
+    int slices(int atHigh) { return std::max(4, atHigh * tessellation / BASE_SLICES); }
+}
+
+GLuint shaderProgram = 0;
+
+static std::string loadShaderSource(const std::string& filename) {
+    std::ifstream file(filename);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+static GLuint compileShader(GLenum type, const std::string& source) {
+    GLuint shader = glCreateShader(type);
+    const char* src = source.c_str();
+    glShaderSource(shader, 1, &src, NULL);
+    glCompileShader(shader);
+    
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "Shader error: " << infoLog << std::endl;
+    }
+    return shader;
+}
+
+void initShaders() {
+    std::string vertexCode = loadShaderSource("phong.vert");
+    std::string fragmentCode = loadShaderSource("phong.frag");
+    
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode);
+    
+    shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+    
+    GLint success;
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "Linking error: " << infoLog << std::endl;
+    }
+    
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    
+    std::cout << "✓ Phong shaders loaded!\n";
+}
+
+ParticleBlend particleBlend = ParticleBlend::Sorted;
+
+static void drawParticles(const ParticleDraw* draws, const std::uint32_t* order, int count, GLUquadric* gQuad) {
+    const bool additive = particleBlend == ParticleBlend::Additive;
+    glDisable(GL_LIGHTING);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    for (int i = 0; i < count; i++) {
+        const ParticleDraw& p = draws[order ? order[i] : i];
+        glColor4f(0.8f, 0.7f, 0.5f, additive ? p.alpha * 0.5f : p.alpha);
+        
+        glPushMatrix();
+        glTranslatef(p.x, p.y, p.z);
+        gluSphere(gQuad, p.size, slices(6), slices(6));
+        glPopMatrix();
+    }
+    
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glEnable(GL_LIGHTING);
+}
+
+static void drawSky(float size = 50.0f)
+{
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    
+    if (G.skyTexture) {
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, G.skyTexture);
+        glColor3f(1.0f, 1.0f, 1.0f);
+    } else {
+        glColor3f(0.4f, 0.6f, 0.9f);
+    }
+
+    glBegin(GL_QUADS);
+
+    glTexCoord2f(0, 0); glVertex3f(-size, -size, -size);
+    glTexCoord2f(1, 0); glVertex3f(size, -size, -size);
+    glTexCoord2f(1, 1); glVertex3f(size, size, -size);
+    glTexCoord2f(0, 1); glVertex3f(-size, size, -size);
+   
+    glTexCoord2f(0, 0); glVertex3f(-size, -size, size);
+    glTexCoord2f(1, 0); glVertex3f(size, -size, size);
+    glTexCoord2f(1, 1); glVertex3f(size, size, size);
+    glTexCoord2f(0, 1); glVertex3f(-size, size, size);
+   
+    glTexCoord2f(0, 0); glVertex3f(-size, -size, -size);
+    glTexCoord2f(1, 0); glVertex3f(-size, -size, size);
+    glTexCoord2f(1, 1); glVertex3f(-size, size, size);
+    glTexCoord2f(0, 1); glVertex3f(-size, size, -size);
+    
+    glTexCoord2f(0, 0); glVertex3f(size, -size, -size);
+    glTexCoord2f(1, 0); glVertex3f(size, -size, size);
+    glTexCoord2f(1, 1); glVertex3f(size, size, size);
+    glTexCoord2f(0, 1); glVertex3f(size, size, -size);
+    
+    glTexCoord2f(0, 0); glVertex3f(-size, size, -size);
+    glTexCoord2f(1, 0); glVertex3f(size, size, -size);
+    glTexCoord2f(1, 1); glVertex3f(size, size, size);
+    glTexCoord2f(0, 1); glVertex3f(-size, size, size);
+    glEnd();
+
+    if (G.skyTexture) {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+    }
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_LIGHTING);
+}
+
+
+void initOpenGL() {
+    glColor3f(0.8f, 0.0f, 0.0f);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_COLOR_MATERIAL);
+    glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
+    glDisable(GL_BLEND);
+
+    GLfloat lightPos[] = { 1.0, 1.0, 1.0, 0.0 };
+    GLfloat white[] = { 1.0, 1.0, 1.0, 1.0 };
+
+    glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, white);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, white);
+
+    glDepthFunc(GL_LEQUAL);
+    glClearDepth(1.0f);
+}
+
+void initLighting() {
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+
+    GLfloat lightAmbient[] = { 0.1f, 0.1f, 0.1f, 1.0f };
+    GLfloat lightDiffuse[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glLightfv(GL_LIGHT0, GL_AMBIENT, lightAmbient);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiffuse);
+}
+
+void setMaterial(float shininess) {
+    GLfloat mat_ambient[] = { 0.2f, 0.2f, 0.2f, 1.0f };
+    GLfloat mat_specular[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    glMaterialfv(GL_FRONT, GL_AMBIENT, mat_ambient);
+    glMaterialf(GL_FRONT, GL_SHININESS, shininess);
+}
+
+
+FramePrep frame;
+static DepthSorter particleSorters[4];
+
+static vecmath::Mat4 projectionFor(int w, int h) {
+    if (!h) h = 1;
+    return vecmath::Mat4::perspective(G.fovDeg, w / static_cast<float>(h), G.nearP, G.farP);
+}
+
+static void setupProjection(const View& v, int x, int y, int w, int h) {
+    glViewport(x, y, (GLsizei)w, (GLsizei)h);
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(v.proj.data());
+    glMatrixMode(GL_MODELVIEW);
+}
+
+static bool freeCamera(const View& v) {
+    return v.cam == ViewCamera::Main && !G.chaseCam;
+}
+
+static void chaseTarget(const View& v, float& laneX, float& pos) {
+    int car = G.localCar;
+    switch (v.cam) {
+    case ViewCamera::ChaseRed: car = 0; break;
+    case ViewCamera::ChaseBlack: car = 1; break;
+    case ViewCamera::ChaseGreen: car = 2; break;
+    default: break;
+    }
+    laneX = carLanes[car];
+    pos = *carPosOf[car];
+}
+
+static float leaderPos() {
+    return std::max(G.carPos, std::max(G.car2Pos, G.car3Pos));
+}
+
+// Camera matrices are built on the CPU so the same view-projection can be
+// used for frustum culling and handed to GL without a readback.
+static void computeViewMatrices(View& v) {
+    using vecmath::Mat4;
+    v.skyView = Mat4::identity();
+
+    if (v.cam == ViewCamera::Overview) {
+        const float z = leaderPos();
+        const float y = groundHeight(-1.0f, z);
+        v.eye = { -1.0f, y + 25.0f, z - 25.0f };
+        v.view = Mat4::lookAt(v.eye, { -1.0f, y, z + 15.0f }, { 0, 1, 0 });
+    }
+    else if (!freeCamera(v)) {
+        float camDistance = 3.0f;
+        float camHeight = 1.5f;
+        float laneX, pos;
+        chaseTarget(v, laneX, pos);
+        v.eye = { laneX, groundHeight(laneX, pos - camDistance) + camHeight, pos - camDistance };
+        v.view = Mat4::lookAt(v.eye, { laneX, groundHeight(laneX, pos) + 0.6f, pos }, { 0, 1, 0 });
+    }
+    else {
+        v.skyView = Mat4::rotateX(G.rotX) * Mat4::rotateY(G.rotY);
+        v.view = Mat4::lookAt(G.eye, G.center, G.up) * v.skyView;
+        v.eye = (Mat4::rotateY(-G.rotY) * Mat4::rotateX(-G.rotX) * vecmath::Vec4(G.eye.x, G.eye.y, G.eye.z, 1.0f)).xyz();
+    }
+    v.frustum = vecmath::extractFrustum(v.proj * v.view);
+}
+
+static void drawAxes(float len = 0.4f) {
+    glDisable(GL_LIGHTING);
+    glLineWidth(2.0f);
+    glBegin(GL_LINES);
+    glColor3f(1, 0, 0); glVertex3f(0, 0, 0); glVertex3f(+len, 0, 0);
+    glColor3f(0, 1, 0); glVertex3f(0, 0, 0); glVertex3f(0, +len, 0);
+    glColor3f(0, 0, 1); glVertex3f(0, 0, 0); glVertex3f(0, 0, +len);
+    glEnd();
+    glEnable(GL_LIGHTING);
+}
+
+
+static GLUquadric* gQuad = nullptr;
+
+void initQuadric() {
+    gQuad = gluNewQuadric();
+    gluQuadricNormals(gQuad, GLU_SMOOTH);
+}
+
+void freeQuadric() {
+    if (gQuad) gluDeleteQuadric(gQuad);
+}
+
+// Unit meshes: the wheel is a closed cylinder of radius 1 along z from 0 to 1,
+// the box a unit cube around the origin. Neither touches the matrix stack;
+// size and orientation come from the caller's transform.
+static void drawUnitWheel() {
+    const int n = slices(24);
+    glBegin(GL_QUAD_STRIP);
+    for (int i = 0; i <= n; i++) {
+        const float a = 2.0f * PI * i / n;
+        const float c = std::cos(a), s = std::sin(a);
+        glNormal3f(c, s, 0.0f);
+        glVertex3f(c, s, 0.0f);
+        glVertex3f(c, s, 1.0f);
+    }
+    glEnd();
+
+    for (int cap = 0; cap < 2; cap++) {
+        const float z = static_cast<float>(cap);
+        glBegin(GL_TRIANGLE_FAN);
+        glNormal3f(0.0f, 0.0f, cap ? 1.0f : -1.0f);
+        glVertex3f(0.0f, 0.0f, z);
+        for (int i = 0; i <= n; i++) {
+            const float a = 2.0f * PI * (cap ? i : n - i) / n;
+            glVertex3f(std::cos(a), std::sin(a), z);
+        }
+        glEnd();
+    }
+}
+
+static void drawUnitBox() {
+    glBegin(GL_QUADS);
+    glNormal3f(0.0f, 0.0f, 1.0f); glVertex3f(-0.5, -0.5, 0.5); glVertex3f(0.5, -0.5, 0.5); glVertex3f(0.5, 0.5, 0.5); glVertex3f(-0.5, 0.5, 0.5);
+    glNormal3f(0.0f, 0.0f, -1.0f); glVertex3f(-0.5, -0.5, -0.5); glVertex3f(-0.5, 0.5, -0.5); glVertex3f(0.5, 0.5, -0.5); glVertex3f(0.5, -0.5, -0.5);
+    glNormal3f(-1.0f, 0.0f, 0.0f); glVertex3f(-0.5, -0.5, -0.5); glVertex3f(-0.5, -0.5, 0.5); glVertex3f(-0.5, 0.5, 0.5); glVertex3f(-0.5, 0.5, -0.5);
+    glNormal3f(1.0f, 0.0f, 0.0f); glVertex3f(0.5, -0.5, -0.5); glVertex3f(0.5, 0.5, -0.5); glVertex3f(0.5, 0.5, 0.5); glVertex3f(0.5, -0.5, 0.5);
+    glNormal3f(0.0f, 1.0f, 0.0f); glVertex3f(-0.5, 0.5, 0.5); glVertex3f(0.5, 0.5, 0.5); glVertex3f(0.5, 0.5, -0.5); glVertex3f(-0.5, 0.5, -0.5);
+    glNormal3f(0.0f, -1.0f, 0.0f); glVertex3f(-0.5, -0.5, 0.5); glVertex3f(-0.5, -0.5, -0.5); glVertex3f(0.5, -0.5, -0.5); glVertex3f(0.5, -0.5, 0.5);
+    glEnd();
+}
+enum class NodeMesh : unsigned char { None, Box, Wheel, Count };
+
+// Nodes are stored in parallel arrays with every parent ahead of its
+// children, so world transforms resolve in one forward pass and only
+// subtrees whose local transform changed are recomputed. `instance` is the
+// world matrix with the node's fixed mesh transform (size, wheel axis)
+// folded in: what the mesh is drawn with.
+struct SceneGraph {
+    std::vector<int> parent;
+    std::vector<vecmath::Mat4> local;
+    std::vector<vecmath::Mat4> world;
+    std::vector<vecmath::Mat4> meshLocal;
+    std::vector<vecmath::Mat4> instance;
+    std::vector<unsigned char> dirty;
+    std::vector<NodeMesh> mesh;
+    std::vector<int> material;
+    int recomputed = 0;
+};
+
+static SceneGraph scene;
+
+static int addNode(int parent, const vecmath::Mat4& local, NodeMesh mesh, const vecmath::Mat4& meshLocal, int material) {
+    scene.parent.push_back(parent);
+    scene.local.push_back(local);
+    scene.world.push_back(local);
+    scene.meshLocal.push_back(meshLocal);
+    scene.instance.push_back(local * meshLocal);
+    scene.dirty.push_back(1);
+    scene.mesh.push_back(mesh);
+    scene.material.push_back(material);
+    return static_cast<int>(scene.parent.size()) - 1;
+}
+
+static void setNodeLocal(int node, const vecmath::Mat4& local) {
+    if (std::memcmp(scene.local[node].m, local.m, sizeof(local.m)) == 0) return;
+    scene.local[node] = local;
+    scene.dirty[node] = 1;
+}
+
+static void updateWorldTransforms() {
+    scene.recomputed = 0;
+    const int n = static_cast<int>(scene.parent.size());
+    for (int i = 0; i < n; i++) {
+        const int p = scene.parent[i];
+        if (p >= 0 && scene.dirty[p]) scene.dirty[i] = 1;
+        if (!scene.dirty[i]) continue;
+        scene.world[i] = p >= 0 ? scene.world[p] * scene.local[i] : scene.local[i];
+        scene.instance[i] = scene.world[i] * scene.meshLocal[i];
+        scene.recomputed++;
+    }
+    std::fill(scene.dirty.begin(), scene.dirty.end(), 0);
+}
+
+struct CarMaterial {
+    float r, g, b;
+    float shaderShininess;
+    float materialShininess;
+};
+
+struct CarNodes {
+    int body;
+    int wheels[4];
+};
+
+static const CarMaterial carMaterials[3] = {
+    { 0.8f, 0.0f, 0.0f, 128.0f, 128.0f },
+    { 0.0f, 0.0f, 0.0f, 64.0f, 50.0f },
+    { 0.0f, 0.8f, 0.0f, 96.0f, 96.0f },
+};
+
+static CarNodes carNodes[3];
+
+static GLint lightPosLoc = -1;
+static GLint lightColorLoc = -1;
+static GLint shininessLoc = -1;
+static GLint modelRowLoc[3] = { -1, -1, -1 };
+
+// One display list per unit mesh, shared by every node that uses it.
+static GLuint carMeshLists = 0;
+
+static void compileCarMeshes() {
+    carMeshLists = glGenLists(static_cast<GLsizei>(NodeMesh::Count));
+    glNewList(carMeshLists + static_cast<GLuint>(NodeMesh::Box), GL_COMPILE);
+    drawUnitBox();
+    glEndList();
+    glNewList(carMeshLists + static_cast<GLuint>(NodeMesh::Wheel), GL_COMPILE);
+    drawUnitWheel();
+    glEndList();
+}
+
+void initCarScene() {
+    const float wheelX = 0.5f;
+    const float wheelZ = 0.4f;
+    const float wheelY = -0.10f;
+    const float wheelRadius = 0.25f;
+    const float wheelWidth = 0.15f;
+    const vecmath::Mat4 wheelMesh = vecmath::Mat4::rotateY(90.0f) *
+        vecmath::Mat4::scale(wheelRadius, wheelRadius, wheelWidth);
+    const float wheelOffsets[4][2] = {
+        { +wheelX, +wheelZ }, { +wheelX, -wheelZ }, { -wheelX, +wheelZ }, { -wheelX, -wheelZ }
+    };
+
+    for (int car = 0; car < 3; car++) {
+        CarNodes& c = carNodes[car];
+        c.body = addNode(-1, vecmath::Mat4::translate(carLanes[car], 0.01f, 0.0f),
+            NodeMesh::Box, vecmath::Mat4::scale(1.0f, 0.3f, 0.7f), car);
+        addNode(c.body, vecmath::Mat4::translate(0.06f, 0.3f, 0.0f), NodeMesh::Box,
+            vecmath::Mat4::scale(0.6f, 0.35f, 0.6f), car);
+        for (int w = 0; w < 4; w++) {
+            c.wheels[w] = addNode(c.body, vecmath::Mat4::translate(wheelOffsets[w][0], wheelY, wheelOffsets[w][1]),
+                NodeMesh::Wheel, wheelMesh, car);
+        }
+    }
+    updateWorldTransforms();
+    compileCarMeshes();
+
+    lightPosLoc = glGetUniformLocation(shaderProgram, "lightPosition");
+    lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
+    shininessLoc = glGetUniformLocation(shaderProgram, "shininess");
+    const char* rowNames[3] = { "modelRow0", "modelRow1", "modelRow2" };
+    for (int r = 0; r < 3; r++) modelRowLoc[r] = glGetAttribLocation(shaderProgram, rowNames[r]);
+}
+
+static void updateCarNodes() {
+    const float pos[3] = { G.carPos, G.car2Pos, G.car3Pos };
+    const float wheelAngle[3] = { G.wheelAngle, G.car2WheelAngle, G.car3WheelAngle };
+
+    for (int car = 0; car < 3; car++) {
+        const CarNodes& c = carNodes[car];
+        setNodeLocal(c.body, vecmath::Mat4::translate(carLanes[car], groundHeight(carLanes[car], pos[car]) + 0.01f, pos[car]));
+        for (int w = 0; w < 4; w++) {
+            const vecmath::Vec3 hub = scene.local[c.wheels[w]].translation();
+            setNodeLocal(c.wheels[w], vecmath::Mat4::translate(hub.x, hub.y, hub.z) *
+                vecmath::Mat4::rotateX(wheelAngle[car]));
+        }
+    }
+    updateWorldTransforms();
+}
+
+// GL 2.1 pseudo-instancing: the modelview matrix holds only the camera, and
+// each node's instance matrix goes to phong.vert as three generic vertex
+// attributes (its top rows) before the shared mesh list is called. Nodes
+// are batched per mesh; nodes whose bounding sphere is outside the view
+// frustum are skipped.
+static void drawCars(const View& v) {
+    static const float wheelColor[3] = { 0.1f, 0.1f, 0.1f };
+
+    glLoadMatrixf(v.view.data());
+    glUseProgram(shaderProgram);
+    glUniform3f(lightPosLoc, 50.0f, 80.0f, 30.0f);
+    glUniform3f(lightColorLoc, 1.0f, 0.95f, 0.8f);
+
+    const int n = static_cast<int>(scene.parent.size());
+    for (NodeMesh mesh : { NodeMesh::Box, NodeMesh::Wheel }) {
+        int boundMaterial = -1;
+        for (int i = 0; i < n; i++) {
+            if (scene.mesh[i] != mesh) continue;
+            if (!vecmath::sphereVisible(v.frustum, scene.world[i].translation(), 0.8f)) continue;
+
+            const int mat = scene.material[i];
+            if (mat != boundMaterial) {
+                const CarMaterial& cm = carMaterials[mat];
+                glUniform1f(shininessLoc, cm.shaderShininess);
+                setMaterial(cm.materialShininess);
+                if (mesh == NodeMesh::Wheel) glColor3f(wheelColor[0], wheelColor[1], wheelColor[2]);
+                else glColor3f(cm.r, cm.g, cm.b);
+                boundMaterial = mat;
+            }
+
+            const float* m = scene.instance[i].m;
+            for (int r = 0; r < 3; r++) glVertexAttrib4f(modelRowLoc[r], m[r], m[4 + r], m[8 + r], m[12 + r]);
+            glCallList(carMeshLists + static_cast<GLuint>(mesh));
+        }
+    }
+
+    glUseProgram(0);
+}
+
+static std::vector<float> terrainVertices;
+static std::vector<GLushort> terrainIndices[2];
+long terrainTriangles = 0;
+
+void initTerrainMesh() {
+
+    const int full = Terrain::PATCH_QUADS;
+    terrainVertices.resize((full + 1) * (full + 1) * Terrain::FLOATS_PER_VERTEX);
+    for (int k = 0; k < 2; k++) {
+        const int quads = full >> k;
+        std::vector<GLushort>& idx = terrainIndices[k];
+        for (int j = 0; j < quads; j++) {
+            for (int i = 0; i < quads; i++) {
+                const GLushort a = static_cast<GLushort>(j * (quads + 1) + i);
+                const GLushort b = static_cast<GLushort>(a + 1);
+                const GLushort c = static_cast<GLushort>(a + quads + 1);
+                const GLushort d = static_cast<GLushort>(c + 1);
+                idx.insert(idx.end(), { a, b, d, a, d, c });
+            }
+        }
+    }
+}
+// Patches were selected in prepareFrame; each one is morphed on the CPU
+// and drawn from a client-side vertex array.
+static void drawTerrain(const View& v) {
+    glEnable(GL_LIGHTING);
+    glEnable(GL_COLOR_MATERIAL);
+
+    if (G.groundTexture) {
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, G.groundTexture);
+        glColor3f(1.0f, 1.0f, 1.0f);
+    } else {
+        glColor3f(0.8f, 0.6f, 0.4f);
+    }
+
+    const float texScale = 1.0f / 104.0f;
+    glInterleavedArrays(GL_T2F_N3F_V3F, 0, terrainVertices.data());
+    for (int i = 0; i < v.terrainPatchCount; i++) {
+        const int quads = terrain.buildPatch(v.terrainPatches[i], v.terrainLod, v.eye, texScale, terrainVertices.data());
+        const std::vector<GLushort>& idx = terrainIndices[quads == Terrain::PATCH_QUADS ? 0 : 1];
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(idx.size()), GL_UNSIGNED_SHORT, idx.data());
+        terrainTriangles += static_cast<long>(idx.size() / 3);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    if (G.groundTexture) {
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+    }
+}
+
+static void drawCactus(float height = 2.0f) {
+    glColor3f(0.2f, 0.6f, 0.2f);
+
+    glPushMatrix();
+    glRotatef(-90, 1, 0, 0);
+    gluCylinder(gQuad, 0.15, 0.12, height, slices(16), 1);
+    glPopMatrix();
+    
+    glPushMatrix();
+    glTranslatef(-0.25f, height * 0.5f, 0);
+    glRotatef(-90, 1, 0, 0);
+    gluCylinder(gQuad, 0.1, 0.08, height * 0.4f, slices(12), 1);
+    glPopMatrix();
+    
+    glPushMatrix();
+    glTranslatef(0.25f, height * 0.6f, 0);
+    glRotatef(-90, 1, 0, 0);
+    gluCylinder(gQuad, 0.1, 0.08, height * 0.5f, slices(12), 1);
+    glPopMatrix();
+}
+
+static void drawStartPole(float height = 2.5f) {
+    glColor3f(1.0f, 0.8f, 0.0f);
+    glPushMatrix();
+    glRotatef(-90, 1, 0, 0);
+    gluCylinder(gQuad, 0.1, 0.1, height, slices(16), 1);
+    glPopMatrix();
+    glColor3f(1.0f, 0.0f, 0.0f);
+    glPushMatrix();
+    glTranslatef(0, height, 0);
+    glRotatef(90, 0, 1, 0);
+    glScalef(0.5f, 0.3f, 0.05f);
+    drawUnitBox();
+    glPopMatrix();
+}
+
+
+static void drawFinishLine(float zPos = 40.0f) {
+    glDisable(GL_LIGHTING);
+    glLineWidth(5.0f);
+    glBegin(GL_LINES);
+    glColor3f(1.0f, 0.0f, 0.0f);
+    glVertex3f(-5.0f, groundHeight(-5.0f, zPos) + 0.03f, zPos);
+    glVertex3f(5.0f, groundHeight(5.0f, zPos) + 0.03f, zPos);
+    glEnd();
+    glEnable(GL_LIGHTING);
+}
+
+// The track corridor is level across x, so the road only follows the
+// terrain along z. Polygon offset keeps it above coarse terrain patches.
+static void drawRoad() {
+    glDisable(GL_LIGHTING);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(-1.0f, -4.0f);
+    
+    glColor3f(0.2f, 0.2f, 0.2f);
+    glBegin(GL_QUAD_STRIP);
+    for (float z = -52.0f; z <= 1200.0f; z += 4.0f) {
+        const float y = groundHeight(-1.0f, z) + 0.02f;
+        glVertex3f(-4.5f, y, z);
+        glVertex3f(2.5f, y, z);
+    }
+    glEnd();
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glLineWidth(3.0f);
+    glBegin(GL_LINES);
+    for (float z = -50.0f; z < 1200.0f; z += 8.0f) {
+        glVertex3f(-1.0f, groundHeight(-1.0f, z) + 0.04f, z);
+        glVertex3f(-1.0f, groundHeight(-1.0f, z + 4.0f) + 0.04f, z + 4.0f);
+    }
+    glEnd();
+    
+    glColor3f(1.0f, 0.9f, 0.0f);
+    glLineWidth(4.0f);
+    for (float x : { -4.3f, 2.3f }) {
+        glBegin(GL_LINE_STRIP);
+        for (float z = -50.0f; z <= 1200.0f; z += 4.0f) {
+            glVertex3f(x, groundHeight(x, z) + 0.04f, z);
+        }
+        glEnd();
+    }
+    
+    glEnable(GL_LIGHTING);
+}
+
+
+struct CactusInstance {
+    float x, z;
+    int list;
+};
+
+static std::vector<CactusInstance> cacti;
+static std::vector<vecmath::Vec3> cactusCenters;
+static std::vector<float> cactusRadii;
+static std::vector<float> cactusHeights;
+static GLuint cactusLists = 0;
+
+// The cactus field never changes, so it is laid out once, sorted by z for
+// range culling, and every distinct cactus shape is compiled into a display
+// list shared by all views.
+static void compileCactusLists() {
+    cactusLists = glGenLists(static_cast<GLsizei>(cactusHeights.size()));
+    for (size_t i = 0; i < cactusHeights.size(); i++) {
+        glNewList(cactusLists + static_cast<GLuint>(i), GL_COMPILE);
+        drawCactus(cactusHeights[i]);
+        glEndList();
+    }
+}
+
+void initSceneObjects() {
+    auto addCactus = [](float x, float y, float z, float height) {
+        (void)y;
+        auto it = std::find(cactusHeights.begin(), cactusHeights.end(), height);
+        int list = static_cast<int>(it - cactusHeights.begin());
+        if (it == cactusHeights.end()) cactusHeights.push_back(height);
+        cacti.push_back({ x, z, list });
+    };
+
+    for (int i = 0; i < 2500; i++) {
+        float z = i * 4.0f - 50.0f;
+        addCactus(-5.5f, 0.0f, z, 1.0f + (i % 4) * 0.3f);
+        addCactus(-7.5f - (i % 2) * 1.0f, 0.0f, z + 1.5f, 1.3f + (i % 3) * 0.4f);
+        addCactus(-10.0f - (i % 3) * 1.5f, 0.0f, z + 0.5f, 1.1f + (i % 5) * 0.3f);
+        addCactus(-13.0f - (i % 4) * 2.0f, 0.0f, z + 2.0f, 1.4f + (i % 4) * 0.5f);
+        addCactus(-16.0f - (i % 2) * 1.0f, 0.0f, z + 1.0f, 1.2f + (i % 3) * 0.3f);
+        addCactus(-19.0f - (i % 5) * 1.5f, 0.0f, z + 2.5f, 1.5f + (i % 4) * 0.4f);
+        addCactus(3.5f, 0.0f, z + 0.8f, 1.1f + (i % 5) * 0.4f);
+        addCactus(5.5f + (i % 2) * 1.0f, 0.0f, z + 2.2f, 1.2f + (i % 4) * 0.3f);
+        addCactus(8.0f + (i % 3) * 1.5f, 0.0f, z + 1.3f, 1.3f + (i % 3) * 0.5f);
+        addCactus(11.0f + (i % 4) * 2.0f, 0.0f, z + 0.7f, 1.0f + (i % 5) * 0.4f);
+        addCactus(14.0f + (i % 2) * 1.0f, 0.0f, z + 2.8f, 1.4f + (i % 3) * 0.3f);
+        addCactus(17.0f + (i % 5) * 1.5f, 0.0f, z + 1.5f, 1.2f + (i % 4) * 0.5f);
+    }
+
+    std::sort(cacti.begin(), cacti.end(),
+        [](const CactusInstance& a, const CactusInstance& b) { return a.z < b.z; });
+    for (const CactusInstance& c : cacti) {
+        const float h = cactusHeights[c.list];
+        cactusCenters.push_back({ c.x, groundHeight(c.x, c.z) + h * 0.5f, c.z });
+        cactusRadii.push_back(h * 0.5f + 0.5f);
+    }
+
+    compileCactusLists();
+}
+
+void freeSceneObjects() {
+    if (cactusLists) glDeleteLists(cactusLists, static_cast<GLsizei>(cactusHeights.size()));
+    cactusLists = 0;
+}
+
+// Trilinear relies on the mipmaps generated when the texture was uploaded.
+static void applyTextureFilter(GLuint tex, TextureFilter filter) {
+    if (!tex) return;
+    static const GLint minFilter[] = { GL_NEAREST, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR };
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter[static_cast<int>(filter)]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter == TextureFilter::Nearest ? GL_NEAREST : GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void applyRenderQuality(const QualityPreset& q) {
+    terrainPixelError = q.terrainPixelError;
+    applyTextureFilter(G.groundTexture, q.textureFilter);
+    applyTextureFilter(G.skyTexture, q.textureFilter);
+
+    if (q.slices == tessellation) return;
+    tessellation = q.slices;
+    if (cactusLists) {
+        glDeleteLists(cactusLists, static_cast<GLsizei>(cactusHeights.size()));
+        compileCactusLists();
+    }
+    if (carMeshLists) {
+        glDeleteLists(carMeshLists, static_cast<GLsizei>(NodeMesh::Count));
+        compileCarMeshes();
+    }
+}
+
+void applyQuality(const QualityPreset& q) {
+    G.farP = q.drawDistance;
+    setParticleCap(q.particleCap);
+    applyRenderQuality(q);
+}
+
+static void drawAt(const View& v, float x, float z) {
+    glLoadMatrixf((v.view * vecmath::Mat4::translate(x, groundHeight(x, z), z)).data());
+}
+
+void drawSceneObjects(const View& v) {
+    for (int i = v.cullBegin; i < v.cullEnd; i++) {
+        if (v.cactusVisible && !v.cactusVisible[i - v.cullBegin]) continue;
+        const CactusInstance& c = cacti[i];
+        drawAt(v, c.x, c.z);
+        glCallList(cactusLists + c.list);
+    }
+    glLoadMatrixf(v.view.data());
+    
+    drawFinishLine(800.0f);
+    
+    drawAt(v, -4.5f, -40.0f);
+    drawStartPole(2.5f);
+    
+    drawAt(v, 2.5f, -40.0f);
+    drawStartPole(2.5f);
+    
+    drawAt(v, -4.5f, 150.0f);
+    drawStartPole(3.0f);
+    
+    drawAt(v, 2.5f, 150.0f);
+    drawStartPole(3.0f);
+
+    glLoadMatrixf(v.view.data());
+}
+void setViewCount(int n) {
+    static const ViewCamera cams[4] = {
+        ViewCamera::Main, ViewCamera::ChaseBlack, ViewCamera::ChaseGreen, ViewCamera::Overview
+    };
+    frame.viewCount = n;
+    for (int i = 0; i < n; i++) {
+        View& v = frame.views[i];
+        v.cam = cams[i];
+        if (n == 1) {
+            v.x = 0.0f; v.y = 0.0f; v.w = 1.0f; v.h = 1.0f;
+        }
+        else if (n == 2) {
+            v.x = 0.0f; v.y = i == 0 ? 0.5f : 0.0f; v.w = 1.0f; v.h = 0.5f;
+        }
+        else {
+            v.x = (i % 2) * 0.5f; v.y = i < 2 ? 0.5f : 0.0f; v.w = 0.5f; v.h = 0.5f;
+        }
+    }
+}
+
+// Work that does not depend on the camera runs once per frame: wheel
+// animation, camera matrices, the terrain patches each view selects and the
+// z-interval each view can see, resolved against the sorted cactus table
+// with two binary searches per view. The cacti in that interval are then
+// tested against the frustum in batches.
+void prepareFrame(float dt, int width, int height) {
+    (void)dt;
+    const float wheelRadius = 0.25f;
+    G.wheelAngle = std::fmod(G.carPos / wheelRadius * 180.0f / PI, 360.0f);
+    G.car2WheelAngle = std::fmod(G.car2Pos / wheelRadius * 180.0f / PI, 360.0f);
+    G.car3WheelAngle = std::fmod(G.car3Pos / wheelRadius * 180.0f / PI, 360.0f);
+    updateCarNodes();
+    frame.particleDraws = prepareParticleDraws(frameArena, frame.particleCount);
+
+    for (int i = 0; i < frame.viewCount; i++) {
+        View& v = frame.views[i];
+        v.proj = projectionFor(static_cast<int>(v.w * width), static_cast<int>(v.h * height));
+        computeViewMatrices(v);
+
+        v.terrainLod = terrain.lodFor(terrainPixelError, v.h * height, G.fovDeg);
+        TerrainPatch* patches = frameArena.alloc<TerrainPatch>(TERRAIN_MAX_PATCHES);
+        v.terrainPatches = patches;
+        const int needed = patches ? terrain.select(v.terrainLod, v.eye, v.frustum, patches, TERRAIN_MAX_PATCHES) : 0;
+        v.terrainPatchCount = std::min(needed, TERRAIN_MAX_PATCHES);
+        terrainPatchStats.highWater = std::max(terrainPatchStats.highWater, needed);
+        if (needed > TERRAIN_MAX_PATCHES) terrainPatchStats.overflows++;
+        v.particleOrder = particleBlend == ParticleBlend::Sorted
+            ? particleSorters[i].sort(frame.particleDraws, frame.particleCount, v.view, G.farP) : nullptr;
+
+        if (v.cam == ViewCamera::Overview) {
+            v.cullNear = leaderPos() - 35.0f;
+            v.cullFar = v.cullNear + G.farP;
+        }
+        else if (!freeCamera(v)) {
+            float laneX, pos;
+            chaseTarget(v, laneX, pos);
+            v.cullNear = pos - 5.0f;
+            v.cullFar = pos + G.farP;
+        }
+        else {
+            const float reach = G.farP + std::abs(G.eye.z) + std::abs(G.eye.x);
+            v.cullNear = -reach;
+            v.cullFar = reach;
+        }
+
+        auto byZ = [](const CactusInstance& c, float z) { return c.z < z; };
+        v.cullBegin = static_cast<int>(
+            std::lower_bound(cacti.begin(), cacti.end(), v.cullNear, byZ) - cacti.begin());
+        v.cullEnd = static_cast<int>(
+            std::lower_bound(cacti.begin(), cacti.end(), v.cullFar, byZ) - cacti.begin());
+
+        const int n = v.cullEnd - v.cullBegin;
+        unsigned char* visible = frameArena.alloc<unsigned char>(n);
+        if (visible) {
+            vecmath::sphereVisible(v.frustum, cactusCenters.data() + v.cullBegin,
+                cactusRadii.data() + v.cullBegin, visible, n);
+        }
+        v.cactusVisible = visible;
+    }
+}
+
+static void renderView(const View& v, int width, int height) {
+    const int x = static_cast<int>(v.x * width);
+    const int y = static_cast<int>(v.y * height);
+    setupProjection(v, x, y, static_cast<int>(v.w * width), static_cast<int>(v.h * height));
+
+    glLoadMatrixf(v.skyView.data());
+    drawSky(200.0f);
+    
+    glLoadMatrixf(v.view.data());
+
+    drawTerrain(v);
+    drawRoad();
+    
+    drawCars(v);
+
+    drawSceneObjects(v);
+    
+
+    drawParticles(frame.particleDraws, v.particleOrder, frame.particleCount, gQuad);
+}
+
+void renderFrame(int width, int height) {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    for (int i = 0; i < frame.viewCount; i++) {
+        renderView(frame.views[i], width, height);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "frame_arena.hpp"
+#include "gl.hpp"
+#include "particle_sort.hpp"
+#include "quality.hpp"
+#include "terrain.hpp"
+#include "vecmath.hpp"
+
+#include <cstdint>
+
+// Everything that issues GL calls. Nothing here depends on SFML: the window
+// and context belong to the app, so this also links against gl_stub.cpp.
+
+// Sorted: back to front per view with "over" blending. Additive: sums the
+// dust colour, which does not depend on draw order, so no sort is needed.
+enum class ParticleBlend { Sorted, Additive };
+
+enum class ViewCamera { Main, ChaseRed, ChaseBlack, ChaseGreen, Overview };
+
+struct View {
+    float x, y, w, h;
+    ViewCamera cam;
+    vecmath::Mat4 proj;
+    vecmath::Mat4 view;
+    vecmath::Mat4 skyView;
+    vecmath::Frustum frustum;
+    vecmath::Vec3 eye;
+    TerrainLod terrainLod;
+    const TerrainPatch* terrainPatches = nullptr;
+    int terrainPatchCount = 0;
+    const std::uint32_t* particleOrder = nullptr;
+    float cullNear = 0.0f, cullFar = 0.0f;
+    int cullBegin = 0, cullEnd = 0;
+    const unsigned char* cactusVisible = nullptr;
+};
+
+struct FramePrep {
+    View views[4];
+    int viewCount = 1;
+    const ParticleDraw* particleDraws = nullptr;
+    int particleCount = 0;
+};
+
+extern FrameArena frameArena;
+extern FramePrep frame;
+extern ParticleBlend particleBlend;
+extern GLuint shaderProgram;
+extern long terrainTriangles;
+
+// Patches one view may draw. A view that needs more loses the rest (counted
+// in overflows, like FrameArena's); highWater is the most any view needed.
+const int TERRAIN_MAX_PATCHES = 1024;
+struct TerrainPatchStats {
+    int highWater = 0;
+    long overflows = 0;
+};
+extern TerrainPatchStats terrainPatchStats;
+
+void initOpenGL();
+void initLighting();
+void setMaterial(float shininess);
+void initShaders();
+void initQuadric();
+void freeQuadric();
+void initCarScene();
+void initTerrainMesh();
+void initSceneObjects();
+void freeSceneObjects();
+
+// Tessellation, terrain detail and texture filtering of a quality preset.
+// Recompiles the cactus display lists when the tessellation changes.
+void applyRenderQuality(const QualityPreset& q);
+// The whole preset: draw distance and particle cap as well.
+void applyQuality(const QualityPreset& q);
+
+void setViewCount(int n);
+void prepareFrame(float dt, int width, int height);
+void renderFrame(int width, int height);
+void drawSceneObjects(const View& v);
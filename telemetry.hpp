@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Race telemetry shared between the game and external readers through a
+// POSIX shared-memory ring. There is a single writer that never waits: each
+// slot carries the sequence number of the sample it holds, readers copy a
+// slot and accept it only if that number is unchanged afterwards, and a
+// reader that falls more than a ring behind skips ahead and counts the loss.
+
+static const char TELEMETRY_SHM_NAME[] = "/carrace_telemetry";
+static const std::uint32_t TELEMETRY_MAGIC = 0x54524352;
+static const std::uint32_t TELEMETRY_VERSION = 1;
+static const std::uint32_t TELEMETRY_CAPACITY = 1024;
+
+struct TelemetryCar {
+    float pos;
+    float speed;
+    std::int32_t finishPlace;
+    std::uint32_t nitroUses;
+};
+
+struct TelemetrySample {
+    std::uint64_t tick;
+    std::int64_t timeUs;
+    float dt;
+    float frameMs;
+    std::uint32_t raceStarted;
+    TelemetryCar cars[3];
+};
+
+struct TelemetrySlot {
+    std::atomic<std::uint64_t> seq;
+    TelemetrySample sample;
+};
+
+struct TelemetryRing {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t capacity;
+    std::uint32_t sampleSize;
+    std::atomic<std::uint64_t> head;
+    TelemetrySlot slots[TELEMETRY_CAPACITY];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "telemetry ring needs lock-free 64-bit atomics");
+
+inline TelemetryRing* telemetryCreate() {
+    const int fd = shm_open(TELEMETRY_SHM_NAME, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return nullptr;
+    if (ftruncate(fd, sizeof(TelemetryRing)) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* mem = mmap(nullptr, sizeof(TelemetryRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return nullptr;
+
+    TelemetryRing* ring = static_cast<TelemetryRing*>(mem);
+    ring->head.store(0, std::memory_order_relaxed);
+    for (auto& slot : ring->slots) slot.seq.store(0, std::memory_order_relaxed);
+    ring->capacity = TELEMETRY_CAPACITY;
+    ring->sampleSize = sizeof(TelemetrySample);
+    ring->version = TELEMETRY_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    ring->magic = TELEMETRY_MAGIC;
+    return ring;
+}
+
+inline void telemetryDestroy(TelemetryRing* ring) {
+    if (!ring) return;
+    munmap(ring, sizeof(TelemetryRing));
+    shm_unlink(TELEMETRY_SHM_NAME);
+}
+
+inline void telemetryPublish(TelemetryRing* ring, const TelemetrySample& sample) {
+    const std::uint64_t n = ring->head.load(std::memory_order_relaxed);
+    TelemetrySlot& slot = ring->slots[n % TELEMETRY_CAPACITY];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sample = sample;
+    slot.seq.store(n + 1, std::memory_order_release);
+    ring->head.store(n + 1, std::memory_order_release);
+}
+
+inline const TelemetryRing* telemetryAttach() {
+    const int fd = shm_open(TELEMETRY_SHM_NAME, O_RDONLY, 0);
+    if (fd < 0) return nullptr;
+    void* mem = mmap(nullptr, sizeof(TelemetryRing), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return nullptr;
+
+    const TelemetryRing* ring = static_cast<const TelemetryRing*>(mem);
+    if (ring->magic != TELEMETRY_MAGIC || ring->version != TELEMETRY_VERSION ||
+        ring->sampleSize != sizeof(TelemetrySample)) {
+        munmap(mem, sizeof(TelemetryRing));
+        return nullptr;
+    }
+    return ring;
+}
+
+inline void telemetryDetach(const TelemetryRing* ring) {
+    if (ring) munmap(const_cast<TelemetryRing*>(ring), sizeof(TelemetryRing));
+}
+
+// Copies the sample with sequence number `next` (1-based) if it is still in
+// the ring. Returns false when nothing new has been published; `lost` counts
+// samples that were overwritten before the reader got to them.
+inline bool telemetryRead(const TelemetryRing* ring, std::uint64_t& next, TelemetrySample& out, std::uint64_t& lost) {
+    for (;;) {
+        const std::uint64_t head = ring->head.load(std::memory_order_acquire);
+        if (next > head) return false;
+        if (head - next >= TELEMETRY_CAPACITY) {
+            const std::uint64_t oldest = head - TELEMETRY_CAPACITY + 1;
+            lost += oldest - next;
+            next = oldest;
+        }
+
+        const TelemetrySlot& slot = ring->slots[(next - 1) % TELEMETRY_CAPACITY];
+        const std::uint64_t before = slot.seq.load(std::memory_order_acquire);
+        std::memcpy(&out, &slot.sample, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::uint64_t after = slot.seq.load(std::memory_order_relaxed);
+        if (before == next && after == next) {
+            next++;
+            return true;
+        }
+        if (before > next || after > next) {
+            lost++;
+            next++;
+        }
+    }
+}
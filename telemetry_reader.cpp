@@ -0,0 +1,46 @@
+#include "telemetry.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <chrono>
+
+int main(int argc, char** argv) {
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--quiet") == 0) quiet = true;
+    }
+
+    const TelemetryRing* ring = nullptr;
+    while (!(ring = telemetryAttach())) {
+        std::printf("Waiting for the game (run it with --telemetry)...\n");
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    std::uint64_t next = ring->head.load(std::memory_order_acquire) + 1;
+    std::uint64_t lost = 0;
+    std::uint64_t received = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+    TelemetrySample s;
+
+    for (;;) {
+        while (telemetryRead(ring, next, s, lost)) {
+            received++;
+            if (quiet) continue;
+            std::printf("tick %6llu  %7.2f ms | red %6.1f (%5.1f) P%d N%u | black %6.1f P%d | green %6.1f P%d\n",
+                (unsigned long long)s.tick, s.frameMs,
+                s.cars[0].pos, s.cars[0].speed, s.cars[0].finishPlace, s.cars[0].nitroUses,
+                s.cars[1].pos, s.cars[1].finishPlace,
+                s.cars[2].pos, s.cars[2].finishPlace);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::seconds(1)) {
+            std::fprintf(stderr, "%llu samples/s, %llu lost\n",
+                (unsigned long long)received, (unsigned long long)lost);
+            received = 0;
+            lastReport = now;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
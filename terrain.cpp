@@ -0,0 +1,345 @@
+#include "terrain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    float hash01(int x, int z, std::uint32_t seed) {
+        std::uint32_t h = static_cast<std::uint32_t>(x) * 374761393u +
+                          static_cast<std::uint32_t>(z) * 668265263u + seed * 982451653u;
+        h = (h ^ (h >> 13)) * 1274126177u;
+        h ^= h >> 16;
+        return h / 4294967296.0f;
+    }
+
+    float valueNoise(float x, float z, std::uint32_t seed) {
+        const float fx = std::floor(x), fz = std::floor(z);
+        const int ix = static_cast<int>(fx), iz = static_cast<int>(fz);
+        float tx = x - fx, tz = z - fz;
+        tx = tx * tx * (3.0f - 2.0f * tx);
+        tz = tz * tz * (3.0f - 2.0f * tz);
+        const float a = hash01(ix, iz, seed), b = hash01(ix + 1, iz, seed);
+        const float c = hash01(ix, iz + 1, seed), d = hash01(ix + 1, iz + 1, seed);
+        return (a + (b - a) * tx) + ((c + (d - c) * tx) - (a + (b - a) * tx)) * tz;
+    }
+
+    // Crescent dune cross-section: long windward slope, short steep lee.
+    float duneProfile(float u) {
+        const float p = u - std::floor(u);
+        float t = p < 0.7f ? p / 0.7f : (1.0f - p) / 0.3f;
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    float smoothstep(float a, float b, float x) {
+        const float t = std::min(1.0f, std::max(0.0f, (x - a) / (b - a)));
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    void boxBlur(std::vector<float>& v, int radius) {
+        const int n = static_cast<int>(v.size());
+        std::vector<float> out(n);
+        for (int i = 0; i < n; i++) {
+            float sum = 0.0f;
+            for (int k = -radius; k <= radius; k++) {
+                sum += v[std::min(n - 1, std::max(0, i + k))];
+            }
+            out[i] = sum / (2 * radius + 1);
+        }
+        v.swap(out);
+    }
+}
+
+void Terrain::generateDunes(int samples, float spacing_, float centerX, float centerZ, std::uint32_t seed) {
+    n = samples;
+    spacing = spacing_;
+    originX = centerX - extent() * 0.5f;
+    originZ = centerZ - extent() * 0.5f;
+    heights.assign(static_cast<std::size_t>(n) * n, 0.0f);
+
+    for (int iz = 0; iz < n; iz++) {
+        const float z = originZ + iz * spacing;
+        for (int ix = 0; ix < n; ix++) {
+            const float x = originX + ix * spacing;
+            const float base = 6.0f * valueNoise(x / 700.0f, z / 700.0f, seed) +
+                               3.0f * valueNoise(x / 250.0f, z / 250.0f, seed + 1);
+            const float warp = 40.0f * valueNoise(x / 300.0f, z / 300.0f, seed + 2);
+            const float amp = 2.0f + 6.0f * valueNoise(x / 400.0f, z / 400.0f, seed + 3);
+            const float ridge = (x * 0.8f + z * 0.6f + warp) / 90.0f;
+            const float ripple = (x * 0.6f - z * 0.8f + warp * 0.5f) / 35.0f;
+            heights[static_cast<std::size_t>(iz) * n + ix] =
+                base + amp * duneProfile(ridge) + 0.25f * amp * duneProfile(ripple);
+        }
+    }
+}
+
+bool Terrain::loadRaw16(const char* path, float spacing_, float heightRange, float centerX, float centerZ) {
+    std::FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        std::fprintf(stderr, "Cannot open heightmap %s\n", path);
+        return false;
+    }
+    std::fseek(f, 0, SEEK_END);
+    const long bytes = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+
+    const int side = static_cast<int>(std::lround(std::sqrt(bytes / 2.0)));
+    if (side <= PATCH_QUADS || static_cast<long>(side) * side * 2 != bytes) {
+        std::fprintf(stderr, "Heightmap %s is not a square 16-bit raw file\n", path);
+        std::fclose(f);
+        return false;
+    }
+
+    std::vector<unsigned char> raw(static_cast<std::size_t>(bytes));
+    const bool ok = std::fread(raw.data(), 1, raw.size(), f) == raw.size();
+    std::fclose(f);
+    if (!ok) {
+        std::fprintf(stderr, "Cannot read heightmap %s\n", path);
+        return false;
+    }
+
+    n = side;
+    spacing = spacing_;
+    originX = centerX - extent() * 0.5f;
+    originZ = centerZ - extent() * 0.5f;
+    heights.resize(static_cast<std::size_t>(n) * n);
+    for (std::size_t i = 0; i < heights.size(); i++) {
+        const unsigned v = raw[i * 2] | (raw[i * 2 + 1] << 8);
+        heights[i] = v / 65535.0f * heightRange;
+    }
+    return true;
+}
+
+void Terrain::flattenCorridor(float centerX, float halfWidth, float blend) {
+    std::vector<float> profile(n);
+    for (int iz = 0; iz < n; iz++) profile[iz] = heightAt(centerX, originZ + iz * spacing);
+    const int radius = std::max(1, static_cast<int>(48.0f / spacing));
+    boxBlur(profile, radius);
+    boxBlur(profile, radius);
+
+    for (int iz = 0; iz < n; iz++) {
+        for (int ix = 0; ix < n; ix++) {
+            const float d = std::abs(originX + ix * spacing - centerX);
+            const float t = smoothstep(halfWidth, halfWidth + blend, d);
+            float& h = heights[static_cast<std::size_t>(iz) * n + ix];
+            h = profile[iz] + (h - profile[iz]) * t;
+        }
+    }
+
+    const float zero = heightAt(centerX, 0.0f);
+    for (float& h : heights) h -= zero;
+}
+
+void Terrain::finalize() {
+    nodesPerSide.clear();
+    bounds.clear();
+    levelError.clear();
+
+    for (int level = 0; level < TerrainLod::MAX_LEVELS; level++) {
+        const int nodeSamples = PATCH_QUADS << level;
+        const int side = (n - 1 + nodeSamples - 1) / nodeSamples;
+        nodesPerSide.push_back(side);
+        std::vector<Bounds> b(static_cast<std::size_t>(side) * side);
+
+        for (int nz = 0; nz < side; nz++) {
+            for (int nx = 0; nx < side; nx++) {
+                Bounds& out = b[static_cast<std::size_t>(nz) * side + nx];
+                out = { 1e30f, -1e30f };
+                if (level == 0) {
+                    for (int iz = nz * PATCH_QUADS; iz <= std::min(n - 1, (nz + 1) * PATCH_QUADS); iz++) {
+                        for (int ix = nx * PATCH_QUADS; ix <= std::min(n - 1, (nx + 1) * PATCH_QUADS); ix++) {
+                            const float h = sample(ix, iz);
+                            out.lo = std::min(out.lo, h);
+                            out.hi = std::max(out.hi, h);
+                        }
+                    }
+                    continue;
+                }
+                const int childSide = nodesPerSide[level - 1];
+                for (int cz = nz * 2; cz < std::min(childSide, nz * 2 + 2); cz++) {
+                    for (int cx = nx * 2; cx < std::min(childSide, nx * 2 + 2); cx++) {
+                        const Bounds& c = bounds[level - 1][static_cast<std::size_t>(cz) * childSide + cx];
+                        out.lo = std::min(out.lo, c.lo);
+                        out.hi = std::max(out.hi, c.hi);
+                    }
+                }
+            }
+        }
+        bounds.push_back(std::move(b));
+
+        // Largest height difference between the full-resolution map and the
+        // grid this level draws, probed on an odd stride so every level's
+        // in-between samples are hit.
+        float err = 0.0f;
+        const int stride = 1 << level;
+        const int probe = std::max(1, (n - 1) / 512) | 1;
+        for (int iz = 0; level > 0 && iz < n; iz += probe) {
+            const int cz = std::min(iz / stride * stride, n - 1 - stride);
+            if (cz < 0) break;
+            const float tz = static_cast<float>(iz - cz) / stride;
+            for (int ix = 0; ix < n; ix += probe) {
+                const int cx = std::min(ix / stride * stride, n - 1 - stride);
+                if (cx < 0) break;
+                const float tx = static_cast<float>(ix - cx) / stride;
+                const float a = sample(cx, cz), b0 = sample(cx + stride, cz);
+                const float c = sample(cx, cz + stride), d = sample(cx + stride, cz + stride);
+                const float top = a + (b0 - a) * tx, bottom = c + (d - c) * tx;
+                err = std::max(err, std::abs(top + (bottom - top) * tz - sample(ix, iz)));
+            }
+        }
+        levelError.push_back(err);
+
+        if (side == 1) break;
+    }
+}
+
+float Terrain::sample(int ix, int iz) const {
+    ix = std::min(n - 1, std::max(0, ix));
+    iz = std::min(n - 1, std::max(0, iz));
+    return heights[static_cast<std::size_t>(iz) * n + ix];
+}
+
+float Terrain::heightAt(float x, float z) const {
+    if (n < 2) return 0.0f;
+    const float fx = std::min(static_cast<float>(n - 1), std::max(0.0f, (x - originX) / spacing));
+    const float fz = std::min(static_cast<float>(n - 1), std::max(0.0f, (z - originZ) / spacing));
+    const int ix = std::min(n - 2, static_cast<int>(fx));
+    const int iz = std::min(n - 2, static_cast<int>(fz));
+    const float tx = fx - ix, tz = fz - iz;
+    const float* row = &heights[static_cast<std::size_t>(iz) * n + ix];
+    const float top = row[0] + (row[1] - row[0]) * tx;
+    const float bottom = row[n] + (row[n + 1] - row[n]) * tx;
+    return top + (bottom - top) * tz;
+}
+
+vecmath::Vec3 Terrain::normalAt(float x, float z, float step) const {
+    const float dx = heightAt(x - step, z) - heightAt(x + step, z);
+    const float dz = heightAt(x, z - step) - heightAt(x, z + step);
+    return vecmath::normalize({ dx, 2.0f * step, dz });
+}
+
+TerrainLod Terrain::lodFor(float pixelError, float viewportHeight, float fovYDeg) const {
+    TerrainLod lod;
+    lod.levels = static_cast<int>(bounds.size());
+    const float k = viewportHeight / (2.0f * std::tan(vecmath::radians(fovYDeg) * 0.5f));
+    const float diag0 = PATCH_QUADS * spacing * 1.41421356f;
+
+    // Level L is drawn out to range[L]; beyond it level L+1 is good enough
+    // once its error projects to at most pixelError. Ranges at least double
+    // per level and start at 1.5 node diagonals, so a node's morph finishes
+    // before its coarser neighbour starts morphing.
+    for (int level = 0; level < lod.levels; level++) {
+        if (level == lod.levels - 1) {
+            lod.range[level] = 1e30f;
+            break;
+        }
+        const float errorRange = levelError[level + 1] * k / pixelError;
+        const float minRange = level == 0 ? 1.5f * diag0 : 2.0f * lod.range[level - 1];
+        lod.range[level] = std::max(errorRange, minRange);
+    }
+    return lod;
+}
+
+bool Terrain::nodeInRange(int level, int nx, int nz, const vecmath::Vec3& eye, float range) const {
+    const float size = (PATCH_QUADS << level) * spacing;
+    const float x0 = originX + nx * size, z0 = originZ + nz * size;
+    const Bounds& b = bounds[level][static_cast<std::size_t>(nz) * nodesPerSide[level] + nx];
+    const float dx = std::max(0.0f, std::max(x0 - eye.x, eye.x - (x0 + size)));
+    const float dy = std::max(0.0f, std::max(b.lo - eye.y, eye.y - b.hi));
+    const float dz = std::max(0.0f, std::max(z0 - eye.z, eye.z - (z0 + size)));
+    return dx * dx + dy * dy + dz * dz <= range * range;
+}
+
+void Terrain::selectNode(int level, int nx, int nz, const TerrainLod& lod, const vecmath::Vec3& eye,
+                         const vecmath::Frustum& frustum, TerrainPatch* out, int cap, int& count) const {
+    const float size = (PATCH_QUADS << level) * spacing;
+    const float x0 = originX + nx * size, z0 = originZ + nz * size;
+    const Bounds& b = bounds[level][static_cast<std::size_t>(nz) * nodesPerSide[level] + nx];
+
+    for (const vecmath::Vec4& p : frustum.planes) {
+        const float px = p.x >= 0.0f ? x0 + size : x0;
+        const float py = p.y >= 0.0f ? b.hi : b.lo;
+        const float pz = p.z >= 0.0f ? z0 + size : z0;
+        if (p.x * px + p.y * py + p.z * pz + p.w < 0.0f) return;
+    }
+
+    bool refine = false;
+    const int childSide = level > 0 ? nodesPerSide[level - 1] : 0;
+    for (int q = 0; level > 0 && q < 4; q++) {
+        const int cx = nx * 2 + (q & 1), cz = nz * 2 + (q >> 1);
+        if (cx < childSide && cz < childSide && nodeInRange(level - 1, cx, cz, eye, lod.range[level - 1])) {
+            refine = true;
+        }
+    }
+    if (!refine) {
+        if (count < cap) out[count] = { x0, z0, size, level };
+        count++;
+        return;
+    }
+
+    // Children inside the finer range recurse; the rest are drawn as
+    // quarters of this node at this node's resolution.
+    for (int q = 0; q < 4; q++) {
+        const int cx = nx * 2 + (q & 1), cz = nz * 2 + (q >> 1);
+        if (cx >= childSide || cz >= childSide) continue;
+        if (nodeInRange(level - 1, cx, cz, eye, lod.range[level - 1])) {
+            selectNode(level - 1, cx, cz, lod, eye, frustum, out, cap, count);
+        }
+        else {
+            if (count < cap) out[count] = { x0 + (q & 1) * size * 0.5f, z0 + (q >> 1) * size * 0.5f, size * 0.5f, level };
+            count++;
+        }
+    }
+}
+
+int Terrain::select(const TerrainLod& lod, const vecmath::Vec3& eye, const vecmath::Frustum& frustum,
+                    TerrainPatch* out, int cap) const {
+    int count = 0;
+    if (bounds.empty()) return 0;
+    const int top = static_cast<int>(bounds.size()) - 1;
+    for (int nz = 0; nz < nodesPerSide[top]; nz++) {
+        for (int nx = 0; nx < nodesPerSide[top]; nx++) {
+            selectNode(top, nx, nz, lod, eye, frustum, out, cap, count);
+        }
+    }
+    return count;
+}
+
+int Terrain::buildPatch(const TerrainPatch& patch, const TerrainLod& lod, const vecmath::Vec3& eye,
+                        float texScale, float* out) const {
+    const float step = spacing * (1 << patch.level);
+    const int quads = static_cast<int>(patch.size / step + 0.5f);
+    const float morphEnd = lod.range[patch.level];
+    const float prev = patch.level > 0 ? lod.range[patch.level - 1] : 0.0f;
+    const float morphStart = prev + (morphEnd - prev) * 0.7f;
+    const float morphScale = 1.0f / (morphEnd - morphStart);
+
+    for (int j = 0; j <= quads; j++) {
+        for (int i = 0; i <= quads; i++) {
+            float x = patch.x + i * step;
+            float z = patch.z + j * step;
+            float h = heightAt(x, z);
+            if ((i | j) & 1) {
+                const float dx = x - eye.x, dy = h - eye.y, dz = z - eye.z;
+                const float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+                const float k = std::min(1.0f, std::max(0.0f, (dist - morphStart) * morphScale));
+                if (k > 0.0f) {
+                    if (i & 1) x -= step * k;
+                    if (j & 1) z -= step * k;
+                    h = heightAt(x, z);
+                }
+            }
+            const vecmath::Vec3 nrm = normalAt(x, z, step);
+            out[0] = x * texScale;
+            out[1] = z * texScale;
+            out[2] = nrm.x;
+            out[3] = nrm.y;
+            out[4] = nrm.z;
+            out[5] = x;
+            out[6] = h;
+            out[7] = z;
+            out += FLOATS_PER_VERTEX;
+        }
+    }
+    return quads;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "vecmath.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Heightmap terrain rendered with a distance-based quadtree LOD (CDLOD).
+// Every selected patch is a regular grid whose odd vertices morph towards
+// the next coarser grid as they approach the end of their LOD range, so
+// neighbouring levels meet without cracks. LOD ranges follow from the
+// geometric error of each level and the allowed screen-space error, which
+// keeps the triangle count tied to what is visible rather than to the size
+// of the map. Nothing here touches OpenGL.
+
+struct TerrainPatch {
+    float x, z;
+    float size;
+    int level;
+};
+
+struct TerrainLod {
+    static const int MAX_LEVELS = 16;
+    int levels = 0;
+    float range[MAX_LEVELS];
+};
+
+class Terrain {
+public:
+    static const int PATCH_QUADS = 16;
+    static const int FLOATS_PER_VERTEX = 8;
+
+    // Samples are `spacing` metres apart and the map is centred on
+    // (centerX, centerZ). `samples` should be 2^k + 1.
+    void generateDunes(int samples, float spacing, float centerX, float centerZ, std::uint32_t seed);
+
+    // Square little-endian 16-bit heightmap; 0..65535 maps to 0..heightRange.
+    bool loadRaw16(const char* path, float spacing, float heightRange, float centerX, float centerZ);
+
+    // Levels a strip along z around centerX down to a smoothed profile of
+    // the terrain under it, and shifts the map so the strip is at height 0
+    // where it crosses z = 0. Used for the race track.
+    void flattenCorridor(float centerX, float halfWidth, float blend);
+
+    // Builds the per-node height bounds and per-level errors. Must be
+    // called after the heights are final.
+    void finalize();
+
+    float heightAt(float x, float z) const;
+    vecmath::Vec3 normalAt(float x, float z, float step) const;
+
+    TerrainLod lodFor(float pixelError, float viewportHeight, float fovYDeg) const;
+
+    // Patches covering the part of the map inside the frustum. Returns how
+    // many the view needs; only the first `cap` are written to `out`.
+    int select(const TerrainLod& lod, const vecmath::Vec3& eye, const vecmath::Frustum& frustum,
+               TerrainPatch* out, int cap) const;
+
+    // Writes the morphed vertices of a patch as interleaved t2 n3 v3 floats
+    // and returns the number of quads along one side (PATCH_QUADS or half).
+    int buildPatch(const TerrainPatch& patch, const TerrainLod& lod, const vecmath::Vec3& eye,
+                   float texScale, float* out) const;
+
+    int samples() const { return n; }
+    float extent() const { return (n - 1) * spacing; }
+
+private:
+    struct Bounds {
+        float lo, hi;
+    };
+
+    void selectNode(int level, int nx, int nz, const TerrainLod& lod, const vecmath::Vec3& eye,
+                    const vecmath::Frustum& frustum, TerrainPatch* out, int cap, int& count) const;
+    bool nodeInRange(int level, int nx, int nz, const vecmath::Vec3& eye, float range) const;
+    float sample(int ix, int iz) const;
+
+    int n = 0;
+    float spacing = 1.0f;
+    float originX = 0.0f, originZ = 0.0f;
+    std::vector<float> heights;
+    std::vector<int> nodesPerSide;
+    std::vector<std::vector<Bounds>> bounds;
+    std::vector<float> levelError;
+};
@@ -0,0 +1,95 @@
+#include "frame_arena.hpp"
+#include "game.hpp"
+#include "particles.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+    class Particles : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            G = AppState();
+            particles.clear();
+            std::srand(1);
+        }
+    };
+
+    Particle at(float z, float life) {
+        return { 0.0f, 1.0f, z, 1.0f, 2.0f, -3.0f, life, 0.1f };
+    }
+}
+
+TEST_F(Particles, SlowCarsRaiseNoDust) {
+    spawnDustParticles(-1.0f, 10.0f, 0.05f, 0.0f);
+    EXPECT_TRUE(particles.empty());
+}
+
+TEST_F(Particles, SpawnsBehindTheCarAtGroundLevel) {
+    spawnDustParticles(-1.0f, 10.0f, 40.0f, 2.0f);
+
+    ASSERT_EQ(particles.size(), DUST_PER_SPAWN);
+    for (const Particle& p : particles) {
+        EXPECT_FLOAT_EQ(p.y, 2.1f);
+        EXPECT_LT(p.z, 10.0f);
+        EXPECT_LT(p.vz, 0.0f);
+        EXPECT_GT(p.life, 0.0f);
+    }
+}
+
+TEST_F(Particles, CapDropsTheOldest) {
+    for (int i = 0; i < 100; i++) spawnDustParticles(-1.0f, static_cast<float>(i), 40.0f, 0.0f);
+
+    ASSERT_EQ(particles.size(), MAX_PARTICLES);
+    EXPECT_GT(particles.front().z, 100.0f - MAX_PARTICLES / DUST_PER_SPAWN - 2.0f);
+}
+
+TEST_F(Particles, UpdateRemovesDeadThenIntegrates) {
+    particles.push_back(at(0.0f, 0.0f));
+    particles.push_back(at(5.0f, 1.0f));
+
+    updateParticles(0.5f);
+
+    ASSERT_EQ(particles.size(), 1u);
+    const Particle& p = particles[0];
+    EXPECT_FLOAT_EQ(p.x, 0.5f);
+    EXPECT_FLOAT_EQ(p.y, 2.0f);
+    EXPECT_FLOAT_EQ(p.z, 3.5f);
+    EXPECT_FLOAT_EQ(p.life, 0.5f);
+    EXPECT_FLOAT_EQ(p.vy, 1.75f);
+}
+
+TEST_F(Particles, DustOnlyOnceTheRaceIsOn) {
+    G.carSpeed = 40.0f;
+    updateDust(0.1f);
+    EXPECT_TRUE(particles.empty());
+
+    G.gameStarted = true;
+    updateDust(0.1f);
+    EXPECT_EQ(particles.size(), 3 * DUST_PER_SPAWN);
+}
+
+TEST_F(Particles, DrawsFadeWithLife) {
+    FrameArena arena(4096);
+    particles.push_back(at(0.0f, 1.0f));
+    particles.push_back(at(1.0f, 0.5f));
+
+    int count = 0;
+    const ParticleDraw* draws = prepareParticleDraws(arena, count);
+
+    ASSERT_EQ(count, 2);
+    EXPECT_FLOAT_EQ(draws[0].alpha, 0.6f);
+    EXPECT_FLOAT_EQ(draws[1].alpha, 0.3f);
+    EXPECT_FLOAT_EQ(draws[1].z, 1.0f);
+}
+
+TEST_F(Particles, FullArenaDrawsNothing) {
+    FrameArena arena(16);
+    particles.push_back(at(0.0f, 1.0f));
+    particles.push_back(at(1.0f, 1.0f));
+
+    int count = -1;
+    prepareParticleDraws(arena, count);
+
+    EXPECT_EQ(count, 0);
+    EXPECT_EQ(arena.overflows, 1u);
+}
@@ -0,0 +1,142 @@
+#include "quality.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+    const char* const PATH = "quality_test.cfg";
+
+    class Quality : public ::testing::Test {
+    protected:
+        void TearDown() override { std::remove(PATH); }
+    };
+}
+
+TEST_F(Quality, HighMatchesThePreviousHardcodedSettings) {
+    const QualityPreset& q = qualityPresets[QUALITY_DEFAULT];
+    EXPECT_STREQ(q.name, "high");
+    EXPECT_EQ(q.slices, 16);
+    EXPECT_EQ(q.particleCap, 200u);
+    EXPECT_FLOAT_EQ(q.drawDistance, 300.0f);
+    EXPECT_EQ(q.windowWidth, 1024u);
+    EXPECT_EQ(q.windowHeight, 768u);
+    EXPECT_EQ(q.textureFilter, TextureFilter::Linear);
+}
+
+TEST_F(Quality, PresetsGetMoreExpensive) {
+    for (int i = 1; i < QUALITY_PRESETS; i++) {
+        EXPECT_GE(qualityPresets[i].slices, qualityPresets[i - 1].slices);
+        EXPECT_GE(qualityPresets[i].particleCap, qualityPresets[i - 1].particleCap);
+        EXPECT_GE(qualityPresets[i].drawDistance, qualityPresets[i - 1].drawDistance);
+        EXPECT_LE(qualityPresets[i].terrainPixelError, qualityPresets[i - 1].terrainPixelError);
+    }
+}
+
+TEST_F(Quality, LooksUpPresetsByName) {
+    EXPECT_EQ(qualityPresetByName("low"), 0);
+    EXPECT_EQ(qualityPresetByName("ultra"), 3);
+    EXPECT_EQ(qualityPresetByName("extreme"), -1);
+}
+
+TEST_F(Quality, PicksTheHighestPresetWithinTheTarget) {
+    QualityConfig c;
+    c.targetFps = 60.0f;
+    const float p95[] = { 5.0f, 9.0f, 16.0f, 25.0f };
+    for (int i = 0; i < QUALITY_PRESETS; i++) c.p95Ms[i] = p95[i];
+    EXPECT_EQ(pickQualityPreset(c), 2);
+
+    c.targetFps = 30.0f;
+    EXPECT_EQ(pickQualityPreset(c), 3);
+}
+
+TEST_F(Quality, FallsBackToLowWhenNothingFits) {
+    QualityConfig c;
+    c.p95Ms[0] = 40.0f;
+    EXPECT_EQ(pickQualityPreset(c), 0);
+}
+
+TEST_F(Quality, UnmeasuredPresetsAreNotPicked) {
+    QualityConfig c;
+    c.p95Ms[0] = 4.0f;
+    c.p95Ms[1] = 20.0f;
+    EXPECT_EQ(pickQualityPreset(c), 0);
+}
+
+TEST_F(Quality, StaleTimingsAboveAMissAreNotPicked) {
+    // ultra and high left over from another GPU; medium just missed on this one.
+    QualityConfig c;
+    c.calibrated = true;
+    c.p95Ms[2] = 10.0f;
+    c.p95Ms[3] = 12.0f;
+    c.meanMs[3] = 11.0f;
+
+    clearQualityMeasurements(c);
+    EXPECT_FALSE(c.calibrated);
+    for (int i = 0; i < QUALITY_PRESETS; i++) {
+        EXPECT_EQ(c.p95Ms[i], 0.0f);
+        EXPECT_EQ(c.meanMs[i], 0.0f);
+    }
+
+    c.p95Ms[0] = 8.0f;
+    c.p95Ms[1] = 25.0f;
+    EXPECT_EQ(pickQualityPreset(c), 0);
+
+    // Even if a caller forgets to clear, a miss caps the choice.
+    c.p95Ms[2] = 10.0f;
+    c.p95Ms[3] = 12.0f;
+    EXPECT_EQ(pickQualityPreset(c), 0);
+}
+
+TEST_F(Quality, FrameTimeSummary) {
+    float ms[100];
+    for (int i = 0; i < 100; i++) ms[i] = static_cast<float>(100 - i);
+    float mean = 0.0f, p95 = 0.0f;
+    summarizeFrameTimes(ms, 100, mean, p95);
+    EXPECT_FLOAT_EQ(mean, 50.5f);
+    EXPECT_FLOAT_EQ(p95, 96.0f);
+
+    summarizeFrameTimes(ms, 0, mean, p95);
+    EXPECT_FLOAT_EQ(p95, 0.0f);
+}
+
+TEST_F(Quality, ConfigRoundTrips) {
+    QualityConfig c;
+    c.preset = 1;
+    c.targetFps = 75.0f;
+    c.calibrated = true;
+    c.renderer = "llvmpipe (LLVM 15.0.6, 256 bits)";
+    c.meanMs[0] = 3.5f;
+    c.p95Ms[0] = 4.25f;
+    c.meanMs[1] = 8.0f;
+    c.p95Ms[1] = 11.5f;
+    ASSERT_TRUE(saveQualityConfig(PATH, c));
+
+    QualityConfig r;
+    ASSERT_TRUE(loadQualityConfig(PATH, r));
+    EXPECT_EQ(r.preset, 1);
+    EXPECT_FLOAT_EQ(r.targetFps, 75.0f);
+    EXPECT_TRUE(r.calibrated);
+    EXPECT_EQ(r.renderer, c.renderer);
+    EXPECT_FLOAT_EQ(r.meanMs[1], 8.0f);
+    EXPECT_FLOAT_EQ(r.p95Ms[0], 4.25f);
+    EXPECT_FLOAT_EQ(r.p95Ms[2], 0.0f);
+}
+
+TEST_F(Quality, HandEditedConfigKeepsDefaultsForBadValues) {
+    std::ofstream(PATH) << "# edited\npreset = ultra\ntarget_fps = -5\nbogus = 1\nms.high = oops\n";
+
+    QualityConfig r;
+    ASSERT_TRUE(loadQualityConfig(PATH, r));
+    EXPECT_EQ(r.preset, 3);
+    EXPECT_FLOAT_EQ(r.targetFps, 60.0f);
+    EXPECT_FALSE(r.calibrated);
+    EXPECT_FLOAT_EQ(r.p95Ms[2], 0.0f);
+}
+
+TEST_F(Quality, MissingConfigIsReported) {
+    QualityConfig r;
+    EXPECT_FALSE(loadQualityConfig("does_not_exist.cfg", r));
+}
@@ -0,0 +1,176 @@
+#include "game.hpp"
+#include "particles.hpp"
+
+#include <gtest/gtest.h>
+
+// Pins the race rules as they are: the finish line is at 800, places are
+// handed out in the order cars reach it (red, black, green within a tick)
+// and never change afterwards.
+
+namespace {
+    const float DT = 0.1f;
+
+    class Race : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            G = AppState();
+            particles.clear();
+        }
+    };
+}
+
+TEST_F(Race, FinishClampsPositionAndStopsCar) {
+    G.gameStarted = true;
+    G.carPos = 799.0f;
+    G.carSpeed = 100.0f;
+
+    updateCarMovement(DT);
+
+    EXPECT_FLOAT_EQ(G.carPos, 800.0f);
+    EXPECT_FLOAT_EQ(G.carSpeed, 0.0f);
+    EXPECT_EQ(G.carFinishPlace, 1);
+    EXPECT_EQ(G.finishOrder, 1);
+}
+
+TEST_F(Race, OpponentsClampAt800Too) {
+    G.gameStarted = true;
+    G.car2Pos = 798.0f;
+    G.car3Pos = 799.0f;
+
+    updateCarMovement(DT);
+
+    EXPECT_FLOAT_EQ(G.car2Pos, 800.0f);
+    EXPECT_FLOAT_EQ(G.car3Pos, 800.0f);
+    EXPECT_FLOAT_EQ(G.car2Speed, 0.0f);
+    EXPECT_FLOAT_EQ(G.car3Speed, 0.0f);
+}
+
+TEST_F(Race, ReachingTheLineExactlyFinishes) {
+    G.gameStarted = true;
+    G.carPos = 800.0f;
+
+    updateCarMovement(DT);
+
+    EXPECT_EQ(G.carFinishPlace, 1);
+    EXPECT_FLOAT_EQ(G.carPos, 800.0f);
+}
+
+TEST_F(Race, PlacesFollowCrossingOrder) {
+    G.gameStarted = true;
+    G.carPos = 790.0f;
+    G.car2Pos = 797.0f;
+    G.car3Pos = 799.0f;
+    G.car2Speed = 20.0f;
+    G.car3Speed = 20.0f;
+
+    updateCarMovement(DT);
+    EXPECT_EQ(G.car3FinishPlace, 1);
+    EXPECT_EQ(G.car2FinishPlace, 0);
+
+    updateCarMovement(DT);
+    EXPECT_EQ(G.car2FinishPlace, 2);
+    EXPECT_EQ(G.carFinishPlace, 0);
+
+    G.carSpeed = 200.0f;
+    updateCarMovement(DT);
+    EXPECT_EQ(G.carFinishPlace, 3);
+    EXPECT_EQ(G.finishOrder, 3);
+}
+
+TEST_F(Race, SameTickFinishesAreOrderedRedBlackGreen) {
+    G.gameStarted = true;
+    G.carPos = 805.0f;
+    G.car2Pos = 810.0f;
+    G.car3Pos = 820.0f;
+
+    updateCarMovement(DT);
+
+    EXPECT_EQ(G.carFinishPlace, 1);
+    EXPECT_EQ(G.car2FinishPlace, 2);
+    EXPECT_EQ(G.car3FinishPlace, 3);
+}
+
+TEST_F(Race, PlacesAreNotReassigned) {
+    G.gameStarted = true;
+    G.carPos = G.car2Pos = G.car3Pos = 800.0f;
+    updateCarMovement(DT);
+    updateCarMovement(DT);
+
+    EXPECT_EQ(G.finishOrder, 3);
+    EXPECT_EQ(G.carFinishPlace, 1);
+    EXPECT_EQ(G.car2FinishPlace, 2);
+    EXPECT_EQ(G.car3FinishPlace, 3);
+}
+
+TEST_F(Race, NothingMovesBeforeStartButPlayerSpeedDecays) {
+    G.carSpeed = 10.0f;
+
+    updateCarMovement(DT);
+
+    EXPECT_FLOAT_EQ(G.carPos, 0.0f);
+    EXPECT_FLOAT_EQ(G.carSpeed, 9.5f);
+    EXPECT_FLOAT_EQ(G.car2Pos, 0.0f);
+    EXPECT_FLOAT_EQ(G.car3Pos, 0.0f);
+    EXPECT_FLOAT_EQ(G.car2Speed, 35.0f);
+    EXPECT_TRUE(particles.empty());
+}
+
+TEST_F(Race, ReversingStopsAtMinus45) {
+    G.gameStarted = true;
+    G.carPos = -44.0f;
+    G.carSpeed = -100.0f;
+
+    updateCarMovement(DT);
+
+    EXPECT_FLOAT_EQ(G.carPos, -45.0f);
+}
+
+TEST_F(Race, RemoteCarsAreNotIntegrated) {
+    G.gameStarted = true;
+    G.carRemote[1] = true;
+    G.car2Pos = 100.0f;
+
+    updateCarMovement(DT);
+    EXPECT_FLOAT_EQ(G.car2Pos, 100.0f);
+
+    // Their finish is still recognised once a snapshot puts them past the line.
+    G.car2Pos = 800.0f;
+    updateCarMovement(DT);
+    EXPECT_EQ(G.car2FinishPlace, 1);
+}
+
+TEST_F(Race, RaceFinishedNeedsEveryCarAtTheLine) {
+    G.carPos = G.car2Pos = G.car3Pos = 800.0f;
+    EXPECT_FALSE(raceFinished());
+
+    G.gameStarted = true;
+    EXPECT_TRUE(raceFinished());
+
+    G.car3Pos = 799.0f;
+    EXPECT_FALSE(raceFinished());
+}
+
+TEST_F(Race, PlayerPlaceRanksByDistanceWhileRacing) {
+    G.carPos = 300.0f;
+    G.car2Pos = 400.0f;
+    G.car3Pos = 200.0f;
+    EXPECT_EQ(playerPlace(), 2);
+
+    G.car3Pos = 300.0f;
+    EXPECT_EQ(playerPlace(), 2);
+
+    G.localCar = 2;
+    EXPECT_EQ(playerPlace(), 2);
+    G.localCar = 1;
+    EXPECT_EQ(playerPlace(), 1);
+}
+
+TEST_F(Race, FinishedCarsRankAheadAndFinishersKeepTheirPlace) {
+    G.carPos = 500.0f;
+    G.car2Pos = 400.0f;
+    G.car2FinishPlace = 1;
+    EXPECT_EQ(playerPlace(), 2);
+
+    G.carFinishPlace = 3;
+    EXPECT_EQ(playerPlace(), 3);
+}
@@ -0,0 +1,93 @@
+#include "game.hpp"
+#include "gl_stub.hpp"
+#include "render.hpp"
+
+#include <gtest/gtest.h>
+
+// Scene traversal against the counting GL stub.
+
+namespace {
+    class Scene : public ::testing::Test {
+    protected:
+        static void SetUpTestSuite() {
+            initTerrain(nullptr);
+            initTerrainMesh();
+            initQuadric();
+            initSceneObjects();
+            initCarScene();
+        }
+
+        static void TearDownTestSuite() {
+            freeSceneObjects();
+            freeQuadric();
+        }
+
+        void SetUp() override {
+            G = AppState();
+            G.gameStarted = true;
+            G.chaseCam = true;
+            G.carPos = 300.0f;
+            frameArena.reset();
+        }
+    };
+
+    int visibleCacti(const View& v) {
+        int n = 0;
+        for (int i = 0; i < v.cullEnd - v.cullBegin; i++) n += v.cactusVisible[i] != 0;
+        return n;
+    }
+}
+
+TEST_F(Scene, DrawsOneListPerVisibleCactus) {
+    setViewCount(1);
+    prepareFrame(1.0f / 60.0f, 1024, 768);
+    const View& v = frame.views[0];
+    ASSERT_NE(v.cactusVisible, nullptr);
+
+    glStubReset();
+    drawSceneObjects(v);
+
+    // Each of the four poles is a GLU cylinder and a box; the finish line is one glBegin.
+    const int visible = visibleCacti(v);
+    EXPECT_GT(visible, 0);
+    EXPECT_LT(visible, v.cullEnd - v.cullBegin);
+    EXPECT_EQ(glStubCounts.drawCalls, visible + 4 * 2 + 1);
+}
+
+TEST_F(Scene, ChaseViewsOnlyWalkCactiAroundTheirCar) {
+    setViewCount(4);
+    prepareFrame(1.0f / 60.0f, 1024, 768);
+
+    const View& chase = frame.views[1];
+    EXPECT_LE(chase.cullNear, G.car2Pos);
+    EXPECT_FLOAT_EQ(chase.cullFar - chase.cullNear, G.farP + 5.0f);
+}
+
+TEST_F(Scene, TerrainSelectionReportsPatchesBeyondTheCap) {
+    setViewCount(1);
+    prepareFrame(1.0f / 60.0f, 1024, 768);
+    const View& v = frame.views[0];
+    ASSERT_GT(v.terrainPatchCount, 4);
+
+    TerrainPatch few[4];
+    EXPECT_EQ(terrain.select(v.terrainLod, v.eye, v.frustum, few, 4), v.terrainPatchCount);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(few[i].x, v.terrainPatches[i].x);
+        EXPECT_EQ(few[i].z, v.terrainPatches[i].z);
+    }
+    EXPECT_EQ(terrainPatchStats.overflows, 0);
+    EXPECT_LE(v.terrainPatchCount, terrainPatchStats.highWater);
+}
+
+TEST_F(Scene, TessellationChangeRecompilesCactusLists) {
+    glStubReset();
+    applyRenderQuality(qualityPresets[QUALITY_DEFAULT]);
+    EXPECT_EQ(glStubCounts.drawCalls, 0);
+
+    applyRenderQuality(qualityPresets[0]);
+    const long lowDraws = glStubCounts.drawCalls;
+    EXPECT_GT(lowDraws, 0);
+
+    applyRenderQuality(qualityPresets[QUALITY_DEFAULT]);
+    EXPECT_EQ(glStubCounts.drawCalls, 2 * lowDraws);
+}
@@ -0,0 +1,133 @@
+#include "vecmath.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Compares the SIMD paths of vecmath against the scalar reference: matrix
+// products, the SoA point transform (against the scalar AoS loop) and
+// frustum culling of bounding spheres. Reports ns per operation and the
+// largest difference.
+
+using namespace vecmath;
+
+namespace {
+    volatile float sink;
+
+    template <typename F>
+    double nsPer(int ops, F&& body) {
+        const auto t0 = std::chrono::steady_clock::now();
+        body();
+        const auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count() / ops;
+    }
+
+    float frand(float lo, float hi) {
+        return lo + (hi - lo) * (std::rand() / static_cast<float>(RAND_MAX));
+    }
+
+    float checksum(const Mat4& m) {
+        float s = 0.0f;
+        for (float v : m.m) s += v;
+        return s;
+    }
+
+    float maxDiff(const Mat4& a, const Mat4& b) {
+        float e = 0.0f;
+        for (int i = 0; i < 16; i++) e = std::fmax(e, std::fabs(a.m[i] - b.m[i]));
+        return e;
+    }
+
+    void report(const char* name, double scalarNs, double simdNs, float err) {
+        std::printf("%-24s scalar %8.2f ns  simd %8.2f ns  x%5.2f  max err %.3g\n",
+            name, scalarNs, simdNs, simdNs > 0.0 ? scalarNs / simdNs : 0.0, err);
+    }
+}
+
+int main(int argc, char** argv) {
+    const int points = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int reps = 50;
+    std::srand(42);
+
+#if VECMATH_SSE
+    std::printf("vecmath: SSE\n");
+#elif VECMATH_NEON
+    std::printf("vecmath: NEON\n");
+#else
+    std::printf("vecmath: scalar only\n");
+#endif
+
+    std::vector<Mat4> mats(1024);
+    for (Mat4& m : mats) {
+        m = Mat4::translate(frand(-5, 5), frand(-5, 5), frand(-5, 5)) *
+            Mat4::rotateY(frand(0, 360)) * Mat4::rotateX(frand(0, 360));
+    }
+
+    {
+        // Each product feeds the next, so neither loop can be dropped or
+        // reduced to the elements that are read back.
+        const int ops = static_cast<int>(mats.size()) * 1000;
+        Mat4 acc = Mat4::identity();
+        const double s = nsPer(ops, [&] {
+            for (int r = 0; r < 1000; r++)
+                for (const Mat4& m : mats) acc = scalar::mul(m, acc);
+        });
+        sink = checksum(acc);
+        acc = Mat4::identity();
+        const double v = nsPer(ops, [&] {
+            for (int r = 0; r < 1000; r++)
+                for (const Mat4& m : mats) acc = mul(m, acc);
+        });
+        sink = checksum(acc);
+        float err = 0.0f;
+        for (std::size_t i = 0; i + 1 < mats.size(); i++)
+            err = std::fmax(err, maxDiff(scalar::mul(mats[i], mats[i + 1]), mul(mats[i], mats[i + 1])));
+        report("mat4 * mat4", s, v, err);
+    }
+
+    std::vector<Vec3> in(points), outS(points);
+    std::vector<float> xs(points), ys(points), zs(points), ox(points), oy(points), oz(points);
+    for (int i = 0; i < points; i++) {
+        in[i] = { frand(-50, 50), frand(0, 10), frand(-50, 850) };
+        xs[i] = in[i].x;
+        ys[i] = in[i].y;
+        zs[i] = in[i].z;
+    }
+    const Mat4 xf = mats[7];
+
+    {
+        const double s = nsPer(points * reps, [&] {
+            for (int r = 0; r < reps; r++) scalar::transformPoints(xf, in.data(), outS.data(), points);
+        });
+        const double soa = nsPer(points * reps, [&] {
+            for (int r = 0; r < reps; r++)
+                transformPointsSoA(xf, xs.data(), ys.data(), zs.data(), ox.data(), oy.data(), oz.data(), points);
+        });
+        float err = 0.0f;
+        for (int i = 0; i < points; i++)
+            err = std::fmax(err, std::fabs(outS[i].x - ox[i]) + std::fabs(outS[i].y - oy[i]) + std::fabs(outS[i].z - oz[i]));
+        report("transform point (SoA)", s, soa, err);
+    }
+
+    {
+        const Frustum f = extractFrustum(Mat4::perspective(60.0f, 16.0f / 9.0f, 0.1f, 300.0f) *
+                                         Mat4::lookAt({ 0, 2, -5 }, { 0, 1, 10 }, { 0, 1, 0 }));
+        std::vector<float> radii(points);
+        for (float& r : radii) r = frand(0.2f, 3.0f);
+        std::vector<unsigned char> visS(points), visV(points);
+        int countS = 0, countV = 0;
+        const double s = nsPer(points * reps, [&] {
+            for (int r = 0; r < reps; r++) countS = scalar::sphereVisible(f, in.data(), radii.data(), visS.data(), points);
+        });
+        const double v = nsPer(points * reps, [&] {
+            for (int r = 0; r < reps; r++) countV = sphereVisible(f, in.data(), radii.data(), visV.data(), points);
+        });
+        int mismatches = 0;
+        for (int i = 0; i < points; i++) mismatches += visS[i] != visV[i];
+        report("sphere vs frustum", s, v, static_cast<float>(mismatches));
+        std::printf("  visible %d / %d (simd %d)\n", countS, points, countV);
+    }
+
+    return 0;
+}